@@ -0,0 +1,215 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "benchmarkclient.h"
+#include "frameproducer.h"
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QHostAddress>
+#include <QUrl>
+#include <QtEndian>
+#include <cstring>
+#include <limits>
+
+#define BENCHMARK_READ_CHUNK (1024 * 1024)
+#define BENCHMARK_THROTTLED_READ_BUFFER (64 * 1024)
+
+BenchmarkClient::BenchmarkClient(CommunicationMode mode, const QString& pipeName, quint16 port, double readMegabytesPerSecond, QObject* parent) : QObject(parent),
+	mode(mode), pipeName(pipeName), port(port), readLimit(readMegabytesPerSecond), device(nullptr), webSocket(nullptr), throttleTimer(nullptr),
+	lastThrottleNs(0), readAllowance(0.0), waitingForPong(true), headerFill(0), payloadRemaining(0), stampFill(0), frames(0), bytes(0), errors(0) {
+	this->scratch.resize(BENCHMARK_READ_CHUNK);
+}
+
+void BenchmarkClient::connectToServer() {
+	// sockets are created here, in the thread the client was moved to
+	if(this->mode == CommunicationMode::WebSocket) {
+		this->webSocket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+		connect(this->webSocket, &QWebSocket::connected, this, &BenchmarkClient::onConnected);
+		connect(this->webSocket, &QWebSocket::textMessageReceived, this, &BenchmarkClient::onTextMessageReceived);
+		connect(this->webSocket, &QWebSocket::binaryMessageReceived, this, &BenchmarkClient::onBinaryMessageReceived);
+		this->webSocket->open(QUrl(QString("ws://127.0.0.1:%1").arg(this->port)));
+		return;
+	}
+
+	if(this->mode == CommunicationMode::TCPIP) {
+		QTcpSocket* socket = new QTcpSocket(this);
+		connect(socket, &QTcpSocket::connected, this, &BenchmarkClient::onConnected);
+		socket->connectToHost(QHostAddress::LocalHost, this->port);
+		if(this->readLimit > 0.0) {
+			socket->setReadBufferSize(BENCHMARK_THROTTLED_READ_BUFFER);
+		}
+		this->device = socket;
+	} else {
+		QLocalSocket* socket = new QLocalSocket(this);
+		connect(socket, &QLocalSocket::connected, this, &BenchmarkClient::onConnected);
+		socket->connectToServer(this->pipeName);
+		if(this->readLimit > 0.0) {
+			socket->setReadBufferSize(BENCHMARK_THROTTLED_READ_BUFFER);
+		}
+		this->device = socket;
+	}
+	connect(this->device, &QIODevice::readyRead, this, &BenchmarkClient::onReadyRead);
+}
+
+void BenchmarkClient::close() {
+	if(this->throttleTimer) {
+		this->throttleTimer->stop();
+	}
+	if(this->webSocket) {
+		this->webSocket->close();
+	} else if(this->device) {
+		this->device->close();
+	}
+}
+
+void BenchmarkClient::onConnected() {
+	// the pong proves that the broadcaster has registered this client, so no frame produced afterwards can be missed
+	if(this->webSocket) {
+		this->webSocket->sendTextMessage("ping");
+	} else {
+		this->device->write("ping\n");
+	}
+	if(this->readLimit > 0.0 && !this->webSocket) {
+		this->throttleTimer = new QTimer(this);
+		this->throttleTimer->setTimerType(Qt::PreciseTimer);
+		connect(this->throttleTimer, &QTimer::timeout, this, &BenchmarkClient::readThrottled);
+		this->clock.start();
+		this->lastThrottleNs = 0;
+		this->throttleTimer->start(1);
+	}
+}
+
+void BenchmarkClient::onReadyRead() {
+	if(this->waitingForPong) {
+		this->pongBuffer.append(this->device->read(qMax<qint64>(0, 5 - this->pongBuffer.size())));
+		if(this->pongBuffer.size() < 5) {
+			return;
+		}
+		this->waitingForPong = false;
+		if(this->pongBuffer != "pong\n") {
+			emit failed(QString("Unexpected reply to ping: %1").arg(QString::fromUtf8(this->pongBuffer)));
+			return;
+		}
+		emit ready();
+	}
+	if(!this->throttleTimer) {
+		this->readAvailable(std::numeric_limits<qint64>::max());
+	}
+}
+
+void BenchmarkClient::readThrottled() {
+	qint64 nowNs = this->clock.nsecsElapsed();
+	this->readAllowance += static_cast<double>(nowNs - this->lastThrottleNs) * this->readLimit * 1.0e-3;  // MB/s = 1e6 bytes per 1e9 ns
+	this->readAllowance = qMin(this->readAllowance, static_cast<double>(BENCHMARK_THROTTLED_READ_BUFFER));
+	this->lastThrottleNs = nowNs;
+	if(!this->waitingForPong) {
+		this->readAvailable(static_cast<qint64>(this->readAllowance));
+	}
+}
+
+void BenchmarkClient::readAvailable(qint64 maxBytes) {
+	while(maxBytes > 0 && this->device->bytesAvailable() > 0) {
+		qint64 read = this->device->read(this->scratch.data(), qMin(maxBytes, static_cast<qint64>(this->scratch.size())));
+		if(read <= 0) {
+			break;
+		}
+		maxBytes -= read;
+		if(this->throttleTimer) {
+			this->readAllowance -= static_cast<double>(read);
+		}
+		this->consume(this->scratch.constData(), read);
+	}
+}
+
+void BenchmarkClient::onTextMessageReceived(const QString& message) {
+	if(this->waitingForPong && message.trimmed() == "pong") {
+		this->waitingForPong = false;
+		emit ready();
+	}
+}
+
+void BenchmarkClient::onBinaryMessageReceived(const QByteArray& message) {
+	// every WebSocket message is exactly one frame
+	this->headerFill = 0;
+	this->consume(message.constData(), message.size());
+}
+
+void BenchmarkClient::consume(const char* data, qint64 size) {
+	this->bytes += static_cast<quint64>(size);
+	while(size > 0) {
+		if(this->headerFill < STREAM_HEADER_BASE_SIZE) {
+			int count = static_cast<int>(qMin(static_cast<qint64>(STREAM_HEADER_BASE_SIZE - this->headerFill), size));
+			memcpy(this->header + this->headerFill, data, static_cast<size_t>(count));
+			this->headerFill += count;
+			data += count;
+			size -= count;
+			if(this->headerFill == STREAM_HEADER_BASE_SIZE) {
+				if(qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(this->header)) != STREAM_START_IDENTIFIER) {
+					this->errors++;
+					emit failed("Lost frame synchronization, stream header expected.");
+					this->close();
+					return;
+				}
+				this->payloadRemaining = qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(this->header + 4));
+				this->stampFill = 0;
+				if(this->payloadRemaining == 0) {
+					this->frameComplete();
+				}
+			}
+			continue;
+		}
+
+		qint64 count = qMin(static_cast<qint64>(this->payloadRemaining), size);
+		if(this->stampFill < BENCHMARK_PAYLOAD_STAMP_SIZE) {
+			int stampCount = static_cast<int>(qMin(static_cast<qint64>(BENCHMARK_PAYLOAD_STAMP_SIZE - this->stampFill), count));
+			memcpy(this->stamp + this->stampFill, data, static_cast<size_t>(stampCount));
+			this->stampFill += stampCount;
+		}
+		this->payloadRemaining -= static_cast<quint64>(count);
+		data += count;
+		size -= count;
+		if(this->payloadRemaining == 0) {
+			this->frameComplete();
+		}
+	}
+}
+
+void BenchmarkClient::frameComplete() {
+	qint64 nowNs = LatencyStats::now();
+	if(this->stampFill == BENCHMARK_PAYLOAD_STAMP_SIZE) {
+		quint64 values[2];
+		memcpy(values, this->stamp, BENCHMARK_PAYLOAD_STAMP_SIZE);
+		this->latencyHistogram.record(nowNs - static_cast<qint64>(values[1]));
+	}
+	this->frames++;
+	this->headerFill = 0;
+}
@@ -0,0 +1,110 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef BENCHMARKCLIENT_H
+#define BENCHMARKCLIENT_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QWebSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QString>
+#include "socketstreamextensionparameters.h"
+#include "streamheader.h"
+#include "latencystats.h"
+
+// In-process consumer of the stream. Parses the frame headers, measures the
+// latency from production to complete reception and optionally reads no
+// faster than a given rate, so that slow clients can be simulated. Reading is
+// throttled through a small socket read buffer, which lets the backpressure
+// reach the sender like it would with a slow remote application.
+class BenchmarkClient : public QObject {
+	Q_OBJECT
+
+public:
+	BenchmarkClient(CommunicationMode mode, const QString& pipeName, quint16 port, double readMegabytesPerSecond, QObject* parent = nullptr);
+
+	double readMegabytesPerSecond() const { return this->readLimit; }
+	quint64 receivedFrames() const { return this->frames; }
+	quint64 receivedBytes() const { return this->bytes; }
+	quint64 protocolErrors() const { return this->errors; }
+	const LatencyHistogram& latency() const { return this->latencyHistogram; }
+
+signals:
+	void ready();
+	void failed(const QString& message);
+
+public slots:
+	void connectToServer();
+	void close();
+
+private slots:
+	void onConnected();
+	void onReadyRead();
+	void onTextMessageReceived(const QString& message);
+	void onBinaryMessageReceived(const QByteArray& message);
+	void readThrottled();
+
+private:
+	void readAvailable(qint64 maxBytes);
+	void consume(const char* data, qint64 size);
+	void frameComplete();
+
+	CommunicationMode mode;
+	QString pipeName;
+	quint16 port;
+	double readLimit;
+	QIODevice* device;
+	QWebSocket* webSocket;
+	QTimer* throttleTimer;
+	QElapsedTimer clock;
+	qint64 lastThrottleNs;
+	double readAllowance;
+	QByteArray scratch;
+	bool waitingForPong;
+	QByteArray pongBuffer;
+
+	char header[STREAM_HEADER_BASE_SIZE];
+	int headerFill;
+	quint64 payloadRemaining;
+	char stamp[16];
+	int stampFill;
+
+	LatencyHistogram latencyHistogram;
+	quint64 frames;
+	quint64 bytes;
+	quint64 errors;
+};
+
+#endif // BENCHMARKCLIENT_H
@@ -0,0 +1,65 @@
+QT += core gui network websockets concurrent
+QMAKE_PROJECT_DEPTH = 0
+
+TARGET = broadcasterbenchmark
+TEMPLATE = app
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+#headless benchmark of the Broadcaster hot path, builds without OCTproZ_DevKit and without widgets (gui is needed for the preview image encoder)
+DEFINES += \
+	QT_DEPRECATED_WARNINGS #emit warnings if depracted Qt features are used
+
+SOURCES += \
+	main.cpp \
+	benchmarkclient.cpp \
+	frameproducer.cpp \
+	../src/binarycommand.cpp \
+	../src/bitdepthconverter.cpp \
+	../src/broadcaster.cpp \
+	../src/commandframer.cpp \
+	../src/commandparsing.cpp \
+	../src/framepool.cpp \
+	../src/frameregion.cpp \
+	../src/latencystats.cpp \
+	../src/payloadcompression.cpp \
+	../src/previewencoder.cpp \
+	../src/qualitycontroller.cpp \
+	../src/sharedmemoryring.cpp \
+	../src/socketoptions.cpp \
+	../src/streamclient.cpp \
+	../src/streamheader.cpp \
+	../src/udpmulticastsender.cpp \
+	../src/volumeassembler.cpp
+
+HEADERS += \
+	benchmarkclient.h \
+	frameproducer.h \
+	../src/binarycommand.h \
+	../src/bitdepthconverter.h \
+	../src/broadcaster.h \
+	../src/commanddispatcher.h \
+	../src/commandframer.h \
+	../src/commandparsing.h \
+	../src/framepool.h \
+	../src/frameregion.h \
+	../src/latencystats.h \
+	../src/payloadcompression.h \
+	../src/previewencoder.h \
+	../src/qualitycontroller.h \
+	../src/sharedmemoryring.h \
+	../src/socketoptions.h \
+	../src/socketstreamextensionparameters.h \
+	../src/streamclient.h \
+	../src/streamheader.h \
+	../src/streamsubscription.h \
+	../src/udpmulticastsender.h \
+	../src/volumeassembler.h
+
+INCLUDEPATH += \
+	../src
+
+#shm_open lives in librt on older glibc versions
+unix:!macx {
+	LIBS += -lrt
+}
@@ -0,0 +1,99 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "frameproducer.h"
+#include "broadcaster.h"
+#include "latencystats.h"
+#include <cstring>
+
+FrameProducer::FrameProducer(Broadcaster* broadcaster, const FrameGeometry& geometry, double framesPerSecond, QSharedPointer<FramePool> framePool, QObject* parent) : QObject(parent),
+	broadcaster(broadcaster), geometry(geometry), framesPerSecond(framesPerSecond), framePool(framePool), timer(nullptr), nextFrameDueNs(0), produced(0), skipped(0) {
+	// synthetic interferogram-like ramp, the content only matters for the compression benchmarks
+	this->source.resize(static_cast<int>(geometry.sizeInBytes()));
+	for(int i = 0; i < this->source.size(); i++) {
+		this->source[i] = static_cast<char>((i * 7) ^ (i >> 9));
+	}
+}
+
+void FrameProducer::start() {
+	if(!this->timer) {
+		this->timer = new QTimer(this);
+		this->timer->setTimerType(Qt::PreciseTimer);
+		connect(this->timer, &QTimer::timeout, this, &FrameProducer::produce);
+	}
+	this->clock.start();
+	this->nextFrameDueNs = 0;
+	this->timer->start(this->framesPerSecond > 0.0 ? 1 : 0);
+}
+
+void FrameProducer::stop() {
+	if(this->timer) {
+		this->timer->stop();
+	}
+}
+
+void FrameProducer::produce() {
+	if(this->framesPerSecond <= 0.0) {
+		this->produceFrame(); // as fast as possible, limited by the frame pool
+		return;
+	}
+	// timer ticks are coarser than the frame interval at high rates, so every tick produces all frames that are due
+	qint64 intervalNs = qRound64(1.0e9 / this->framesPerSecond);
+	qint64 nowNs = this->clock.nsecsElapsed();
+	while(this->nextFrameDueNs <= nowNs) {
+		this->produceFrame();
+		this->nextFrameDueNs += intervalNs;
+	}
+}
+
+bool FrameProducer::produceFrame() {
+	qint64 receivedNs = LatencyStats::now();
+	FrameRef frame = this->framePool->acquire(this->geometry.sizeInBytes());
+	if(frame.isNull()) {
+		this->skipped++;
+		return false;
+	}
+	memcpy(frame->data, this->source.constData(), static_cast<size_t>(this->geometry.sizeInBytes()));
+	quint64 stamp[2] = {this->produced, static_cast<quint64>(receivedNs)};
+	memcpy(frame->data, stamp, BENCHMARK_PAYLOAD_STAMP_SIZE);
+	frame->bitDepth = this->geometry.bitDepth;
+	frame->samplesPerLine = this->geometry.samplesPerLine;
+	frame->linesPerFrame = this->geometry.linesPerFrame;
+	frame->framesPerBuffer = this->geometry.framesPerBuffer;
+	frame->buffersPerVolume = 1;
+	frame->currentBufferNr = 0;
+	frame->receivedNs = receivedNs;
+	this->produced++;
+
+	QMetaObject::invokeMethod(this->broadcaster, "broadcast", Qt::QueuedConnection, Q_ARG(FrameRef, frame));
+	return true;
+}
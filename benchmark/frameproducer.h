@@ -0,0 +1,92 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef FRAMEPRODUCER_H
+#define FRAMEPRODUCER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QSharedPointer>
+#include "framepool.h"
+
+class Broadcaster;
+
+#define BENCHMARK_PAYLOAD_STAMP_SIZE 16 // sequence number and LatencyStats::now() at production, both native endian quint64
+
+struct FrameGeometry {
+	quint32 samplesPerLine;
+	quint32 linesPerFrame;
+	quint32 framesPerBuffer;
+	quint8 bitDepth;
+
+	quint64 sizeInBytes() const { return static_cast<quint64>(samplesPerLine) * linesPerFrame * framesPerBuffer * ((bitDepth + 7) / 8); }
+};
+
+// Stands in for the acquisition callback of OCTproZ: copies a synthetic
+// buffer into a frame pool slot at a fixed rate and hands it to the
+// broadcaster, the same way SocketStreamExtension::broadcastBuffer() does.
+// The first bytes of each payload carry a sequence number and the production
+// time, so that the benchmark clients can measure the end-to-end latency.
+class FrameProducer : public QObject {
+	Q_OBJECT
+
+public:
+	FrameProducer(Broadcaster* broadcaster, const FrameGeometry& geometry, double framesPerSecond, QSharedPointer<FramePool> framePool, QObject* parent = nullptr);
+
+	quint64 producedFrames() const { return this->produced; }
+	quint64 skippedFrames() const { return this->skipped; }
+
+public slots:
+	void start();
+	void stop();
+
+private slots:
+	void produce();
+
+private:
+	bool produceFrame();
+
+	Broadcaster* broadcaster;
+	FrameGeometry geometry;
+	double framesPerSecond;
+	QSharedPointer<FramePool> framePool;
+	QByteArray source;
+	QTimer* timer;
+	QElapsedTimer clock;
+	qint64 nextFrameDueNs;
+	quint64 produced;
+	quint64 skipped;
+};
+
+#endif // FRAMEPRODUCER_H
@@ -0,0 +1,523 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+// Headless throughput and latency benchmark of the Broadcaster.
+// Synthetic frames are produced at a configurable rate and broadcast to N
+// in-process clients over TCP, IPC (local socket) or WebSocket. With
+// --commands, the command path is measured instead: text and binary
+// commands per second. The result is printed as JSON, see README.md in this folder.
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpSocket>
+#include <QScopedPointer>
+#include <QFile>
+#include <QTextStream>
+#include <QtEndian>
+#include <QtNumeric>
+#include <functional>
+#include <cstring>
+#include "broadcaster.h"
+#include "commanddispatcher.h"
+#include "frameproducer.h"
+#include "benchmarkclient.h"
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace {
+	qint64 processCpuTimeUs() {
+#ifdef Q_OS_UNIX
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return (static_cast<qint64>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#elif defined(Q_OS_WIN)
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime);
+		auto toUs = [](const FILETIME& time) { return ((static_cast<qint64>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10; };
+		return toUs(kernelTime) + toUs(userTime);
+#else
+		return 0;
+#endif
+	}
+
+	bool waitUntil(const std::function<bool()>& condition, int timeoutMs) {
+		QElapsedTimer timer;
+		timer.start();
+		while(!condition()) {
+			if(timer.elapsed() > timeoutMs) {
+				return false;
+			}
+			QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+		}
+		return true;
+	}
+
+	void processEventsFor(int durationMs) {
+		waitUntil([]() { return false; }, durationMs);
+	}
+
+	QJsonObject latencyToJson(const LatencyHistogram& histogram) {
+		QJsonObject latency;
+		latency["p50"] = static_cast<double>(histogram.percentileUs(50.0));
+		latency["p99"] = static_cast<double>(histogram.percentileUs(99.0));
+		latency["p99_9"] = static_cast<double>(histogram.percentileUs(99.9));
+		latency["max"] = static_cast<double>(histogram.maxUs());
+		return latency;
+	}
+
+	QJsonObject socketOptionsToJson(const SocketOptions& options) {
+		QJsonObject json;
+		json["no_delay"] = options.noDelay;
+		json["send_buffer_kb"] = options.sendBufferKilobytes;
+		json["keepalive_idle_s"] = options.keepAliveIdleSeconds;
+		json["keepalive_interval_s"] = options.keepAliveIntervalSeconds;
+		json["cork"] = options.cork;
+		json["notsent_lowat_kb"] = options.notSentLowatKilobytes;
+		return json;
+	}
+
+	// sends all commands with one write over a new connection and measures until the last one has been dispatched
+	QJsonObject measureCommandThroughput(CommunicationMode mode, const SocketStreamExtensionParameters& params, const QByteArray& commands, int count, int& dispatched) {
+		QJsonObject result;
+		QScopedPointer<QIODevice> socket;
+		bool connected = false;
+		if(mode == CommunicationMode::IPC) {
+			QLocalSocket* localSocket = new QLocalSocket();
+			socket.reset(localSocket);
+			localSocket->connectToServer(params.pipeName);
+			connected = localSocket->waitForConnected(5000);
+		} else {
+			QTcpSocket* tcpSocket = new QTcpSocket();
+			socket.reset(tcpSocket);
+			tcpSocket->connectToHost(params.ip, params.port);
+			connected = tcpSocket->waitForConnected(5000);
+		}
+		if(!connected) {
+			result["error"] = socket->errorString();
+			return result;
+		}
+		processEventsFor(200); // the broadcaster registers the client before the commands arrive
+
+		dispatched = 0;
+		qint64 cpuStartUs = processCpuTimeUs();
+		QElapsedTimer clock;
+		clock.start();
+		socket->write(commands);
+		if(!waitUntil([&dispatched, count]() { return dispatched >= count; }, 60000)) {
+			result["error"] = QString("only %1 of %2 commands dispatched").arg(dispatched).arg(count);
+		}
+		double seconds = clock.nsecsElapsed() * 1.0e-9;
+		qint64 cpuUs = processCpuTimeUs() - cpuStartUs;
+		socket->close();
+
+		result["bytes"] = commands.size();
+		result["dispatched"] = dispatched;
+		result["commands_per_second"] = dispatched / seconds;
+		result["cpu_us_per_command"] = dispatched > 0 ? static_cast<double>(cpuUs) / dispatched : 0.0;
+		return result;
+	}
+
+	int writeResult(const QCommandLineParser& parser, const QJsonObject& result) {
+		QByteArray json = QJsonDocument(result).toJson(QJsonDocument::Indented);
+		if(parser.isSet("output")) {
+			QFile file(parser.value("output"));
+			if(!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+				qCritical("Could not write %s", qPrintable(parser.value("output")));
+				return 1;
+			}
+			file.write(json);
+		} else {
+			QTextStream(stdout) << json;
+		}
+		return 0;
+	}
+
+	bool parseMode(const QString& name, CommunicationMode& mode) {
+		if(name == "tcp") {
+			mode = CommunicationMode::TCPIP;
+		} else if(name == "ipc") {
+			mode = CommunicationMode::IPC;
+		} else if(name == "websocket") {
+			mode = CommunicationMode::WebSocket;
+		} else {
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("broadcasterbenchmark");
+
+	qRegisterMetaType<SocketStreamExtensionParameters>("SocketStreamExtensionParameters");
+	qRegisterMetaType<CommunicationMode>("CommunicationMode");
+	qRegisterMetaType<FrameRef>("FrameRef");
+	qRegisterMetaType<DropPolicy>("DropPolicy");
+	qRegisterMetaType<StreamSubscription>("StreamSubscription");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Headless throughput and latency benchmark of the SocketStreamExtension Broadcaster");
+	parser.addHelpOption();
+	parser.addOptions({
+		{"mode", "Transport: tcp, ipc or websocket.", "mode", "tcp"},
+		{"clients", "Number of in-process clients.", "n", "1"},
+		{"width", "Samples per line.", "samples", "1024"},
+		{"height", "Lines per frame.", "lines", "512"},
+		{"frames", "Frames per buffer.", "frames", "1"},
+		{"bit-depth", "Bit depth of the samples.", "bits", "16"},
+		{"fps", "Buffers per second, 0 = as fast as the frame pool allows.", "rate", "100"},
+		{"duration", "Measurement duration in seconds.", "seconds", "10"},
+		{"read-speed", "Comma separated read speeds in MB/s assigned to the clients in turn, 0 = unlimited. Ignored for WebSocket clients.", "list", "0"},
+		{"queue-frames", "Send queue limit per client in frames.", "frames", "8"},
+		{"queue-megabytes", "Send queue limit per client in MB, 0 = frame limit only.", "megabytes", "1024"},
+		{"drop-newest", "Drop the newest instead of the oldest frame when a send queue is full."},
+		{"batch-frames", "Queued buffers written to a tcp/ipc client in one write, 1 = no batching.", "frames", "1"},
+		{"batch-kilobytes", "Max size of one batched write in KB.", "kilobytes", "1024"},
+		{"batch-us", "Batching window in microseconds, 0 = only batch buffers that are already queued.", "microseconds", "0"},
+		{"nagle", "Leave Nagle's algorithm on, by default the benchmark sets TCP_NODELAY."},
+		{"send-buffer-kb", "SO_SNDBUF of the client connections in KB, 0 = system default.", "kilobytes", "0"},
+		{"keepalive-idle", "TCP keepalive idle time in seconds, 0 = no keepalive.", "seconds", "0"},
+		{"keepalive-interval", "TCP keepalive probe interval in seconds, 0 = system default.", "seconds", "0"},
+		{"cork", "Set TCP_CORK while frames are queued (Linux)."},
+		{"notsent-lowat-kb", "TCP_NOTSENT_LOWAT in KB, 0 = system default.", "kilobytes", "0"},
+		{"sender-threads", "Sender threads of the broadcaster.", "threads", "2"},
+		{"pool-slots", "Fixed number of frame pool slots, 0 = sized by the broadcaster for the clients like in the extension.", "slots", "0"},
+		{"port", "TCP/WebSocket port.", "port", "23456"},
+		{"commands", "Measure the command path instead of the frame path: send this many set_disp_coeff commands, as text and as binary commands. tcp or ipc only.", "count"},
+		{"curve-samples", "With --commands, send set_klin_curve commands with this many values instead of set_disp_coeff.", "samples", "0"},
+		{"output", "Write the JSON result to this file instead of stdout.", "file"},
+	});
+	parser.process(app);
+
+	CommunicationMode mode;
+	if(!parseMode(parser.value("mode"), mode)) {
+		qCritical("Unknown mode %s, expected tcp, ipc or websocket.", qPrintable(parser.value("mode")));
+		return 1;
+	}
+	FrameGeometry geometry;
+	geometry.samplesPerLine = parser.value("width").toUInt();
+	geometry.linesPerFrame = parser.value("height").toUInt();
+	geometry.framesPerBuffer = parser.value("frames").toUInt();
+	geometry.bitDepth = static_cast<quint8>(parser.value("bit-depth").toUInt());
+	if(geometry.bitDepth == 0 || geometry.bitDepth > 32 || geometry.sizeInBytes() < BENCHMARK_PAYLOAD_STAMP_SIZE || geometry.sizeInBytes() > 0xFFFFFFFFull) {
+		qCritical("Invalid frame geometry.");
+		return 1;
+	}
+	int clientCount = qMax(1, parser.value("clients").toInt());
+	double framesPerSecond = parser.value("fps").toDouble();
+	double durationSeconds = parser.value("duration").toDouble();
+	QList<double> readSpeeds;
+	for(const QString& speed : parser.value("read-speed").split(',', QString::SkipEmptyParts)) {
+		readSpeeds.append(speed.toDouble());
+	}
+	if(readSpeeds.isEmpty()) {
+		readSpeeds.append(0.0);
+	}
+
+	SocketStreamExtensionParameters params;
+	params.mode = mode;
+	params.pipeName = QString("octproz_benchmark_%1").arg(QCoreApplication::applicationPid());
+	params.ip = "127.0.0.1";
+	params.port = static_cast<quint16>(parser.value("port").toUInt());
+	params.webSocketPort = params.port;
+	params.listenTcp = false;
+	params.listenIpc = false;
+	params.listenWebSocket = false;
+	params.sendHeader = true;
+	params.headerVersion = 1;
+	params.sendTimestamp = false;
+	params.socketOptions.noDelay = !parser.isSet("nagle");
+	params.socketOptions.sendBufferKilobytes = qBound(0, parser.value("send-buffer-kb").toInt(), SOCKET_SEND_BUFFER_MAX_KILOBYTES);
+	params.socketOptions.keepAliveIdleSeconds = qBound(0, parser.value("keepalive-idle").toInt(), SOCKET_KEEPALIVE_MAX_SECONDS);
+	params.socketOptions.keepAliveIntervalSeconds = qBound(0, parser.value("keepalive-interval").toInt(), SOCKET_KEEPALIVE_MAX_SECONDS);
+	params.socketOptions.cork = parser.isSet("cork");
+	params.socketOptions.notSentLowatKilobytes = qBound(0, parser.value("notsent-lowat-kb").toInt(), SOCKET_NOTSENT_LOWAT_MAX_KILOBYTES);
+	params.autoConnect = false;
+	params.sendQueueMaxFrames = parser.value("queue-frames").toInt();
+	params.sendQueueMaxMegabytes = parser.value("queue-megabytes").toInt();
+	params.dropPolicy = parser.isSet("drop-newest") ? DropPolicy::DropNewest : DropPolicy::DropOldest;
+	params.batchMaxFrames = parser.value("batch-frames").toInt();
+	params.batchMaxKilobytes = parser.value("batch-kilobytes").toInt();
+	params.batchMaxMicroseconds = parser.value("batch-us").toInt();
+	params.sharedMemorySlots = 0;
+	params.senderThreads = parser.value("sender-threads").toInt();
+	params.multicastGroup = "239.255.0.1";
+	params.multicastPort = 0;
+	params.multicastTtl = 1;
+	params.multicastDatagramSize = 1472;
+
+	// broadcaster thread set up like in SocketStreamExtension
+	int poolSlots = parser.value("pool-slots").toInt();
+	QSharedPointer<FramePool> framePool = QSharedPointer<FramePool>::create(poolSlots > 0 ? poolSlots : 10);
+	QThread broadcasterThread;
+	Broadcaster* broadcaster = new Broadcaster();
+	if(poolSlots <= 0) {
+		broadcaster->setFramePool(framePool);
+	}
+	broadcaster->moveToThread(&broadcasterThread);
+	QObject::connect(&broadcasterThread, &QThread::finished, broadcaster, &Broadcaster::deleteLater);
+	QObject::connect(broadcaster, &Broadcaster::error, &app, [](const QString message) { qWarning("%s", qPrintable(message)); });
+	bool listening = false;
+	QObject::connect(broadcaster, &Broadcaster::listeningEnabled, &app, [&listening](bool enabled) { listening = enabled; });
+	broadcasterThread.start();
+
+	QLocalServer::removeServer(params.pipeName);
+	QMetaObject::invokeMethod(broadcaster, "setParams", Qt::QueuedConnection, Q_ARG(SocketStreamExtensionParameters, params));
+	QMetaObject::invokeMethod(broadcaster, "startBroadcasting", Qt::QueuedConnection);
+	if(!waitUntil([&listening]() { return listening; }, 5000)) {
+		qCritical("Broadcaster did not start listening.");
+		broadcasterThread.quit();
+		broadcasterThread.wait();
+		return 1;
+	}
+
+	if(parser.isSet("commands")) {
+		if(mode == CommunicationMode::WebSocket) {
+			qCritical("--commands supports tcp and ipc only.");
+			broadcasterThread.quit();
+			broadcasterThread.wait();
+			return 1;
+		}
+		int commandCount = qMax(1, parser.value("commands").toInt());
+		int dispatched = 0;
+
+		// lookup and parsing as in SocketStreamExtension, the request signals are left out
+		CommandDispatcher<> commands;
+		commands.addTextCommand("set_disp_coeff", [&dispatched](const QString& command) {
+			double coeffs[4];
+			bool present[4];
+			if(CommandParsing::parseCoefficients(command.trimmed(), coeffs, present)) {
+				dispatched++;
+			}
+		});
+		commands.addBinaryCommand(BinaryOpcode::SetDispCoeff, [&dispatched](BinaryCommandReader& payload) {
+			for(int i = 0; i < 4; i++) {
+				payload.readF64();
+			}
+			if(payload.isValid() && payload.atEnd()) {
+				dispatched++;
+			}
+		});
+		commands.addTextCommand("set_klin_curve", [&dispatched](const QString& command) {
+			QVector<float> curve;
+			QString invalidValue;
+			if(CommandParsing::parseFloatList(command.mid(command.indexOf(':') + 1), curve, invalidValue) && !curve.isEmpty()) {
+				dispatched++;
+			}
+		});
+		commands.addBinaryCommand(BinaryOpcode::SetKLinCurve, [&dispatched](BinaryCommandReader& payload) {
+			QVector<float> curve;
+			if(payload.readF32Array(curve, payload.readU32()) && payload.atEnd() && !curve.isEmpty()) {
+				dispatched++;
+			}
+		});
+		QObject::connect(broadcaster, &Broadcaster::remoteCommandReceived, &app, [&commands](const QString& command) {
+			commands.dispatchText(command);
+		});
+		QObject::connect(broadcaster, &Broadcaster::remoteBinaryCommandReceived, &app, [&commands](quint16 opcode, const QByteArray& payload) {
+			commands.dispatchBinary(opcode, payload);
+		});
+
+		int curveSamples = qMax(0, parser.value("curve-samples").toInt());
+		QByteArray textCommand;
+		QByteArray payload;
+		quint16 opcode;
+		if(curveSamples > 0) {
+			// a resampling curve like the ones calibration scripts upload
+			textCommand = "set_klin_curve:";
+			payload.resize(static_cast<int>(sizeof(quint32) + curveSamples * sizeof(float)));
+			qToLittleEndian<quint32>(static_cast<quint32>(curveSamples), payload.data());
+			for(int i = 0; i < curveSamples; i++) {
+				float value = i + 0.0001f * i * i / curveSamples;
+				textCommand += QByteArray::number(value, 'g', 9) + (i + 1 < curveSamples ? "," : "\n");
+				quint32 bits;
+				memcpy(&bits, &value, sizeof(bits));
+				qToLittleEndian<quint32>(bits, payload.data() + sizeof(quint32) + i * sizeof(bits));
+			}
+			opcode = BinaryOpcode::SetKLinCurve;
+		} else {
+			const double coeffs[4] = {0.125, -0.0025, 0.0000375, qQNaN()};
+			payload.resize(4 * sizeof(double));
+			for(int i = 0; i < 4; i++) {
+				quint64 bits;
+				memcpy(&bits, &coeffs[i], sizeof(bits));
+				qToLittleEndian<quint64>(bits, payload.data() + i * sizeof(bits));
+			}
+			textCommand = "set_disp_coeff:0.125:-0.0025:0.0000375:null\n";
+			opcode = BinaryOpcode::SetDispCoeff;
+		}
+		QByteArray binaryCommand = BinaryCommand::frame(opcode, payload);
+		QByteArray textCommands;
+		QByteArray binaryCommands;
+		textCommands.reserve(textCommand.size() * commandCount);
+		binaryCommands.reserve(binaryCommand.size() * commandCount);
+		for(int i = 0; i < commandCount; i++) {
+			textCommands.append(textCommand);
+			binaryCommands.append(binaryCommand);
+		}
+
+		QJsonObject config;
+		config["mode"] = parser.value("mode");
+		config["commands"] = commandCount;
+		config["command"] = curveSamples > 0 ? "set_klin_curve" : "set_disp_coeff";
+		config["curve_samples"] = curveSamples;
+		QJsonObject result;
+		result["config"] = config;
+		result["text"] = measureCommandThroughput(mode, params, textCommands, commandCount, dispatched);
+		result["binary"] = measureCommandThroughput(mode, params, binaryCommands, commandCount, dispatched);
+
+		QMetaObject::invokeMethod(broadcaster, "stopBroadcasting", Qt::BlockingQueuedConnection);
+		broadcasterThread.quit();
+		broadcasterThread.wait();
+		return writeResult(parser, result);
+	}
+
+	// every client reads in a thread of its own, so a throttled client does not slow down the others
+	QList<QThread*> clientThreads;
+	QList<BenchmarkClient*> clients;
+	int readyClients = 0;
+	for(int i = 0; i < clientCount; i++) {
+		QThread* thread = new QThread();
+		BenchmarkClient* client = new BenchmarkClient(mode, params.pipeName, params.port, readSpeeds.at(i % readSpeeds.size()));
+		client->moveToThread(thread);
+		QObject::connect(client, &BenchmarkClient::ready, &app, [&readyClients]() { readyClients++; });
+		QObject::connect(client, &BenchmarkClient::failed, &app, [](const QString& message) { qWarning("%s", qPrintable(message)); });
+		thread->start();
+		QMetaObject::invokeMethod(client, "connectToServer", Qt::QueuedConnection);
+		clientThreads.append(thread);
+		clients.append(client);
+	}
+	if(!waitUntil([&readyClients, clientCount]() { return readyClients == clientCount; }, 10000)) {
+		qCritical("Only %d of %d clients connected.", readyClients, clientCount);
+	}
+
+	QThread producerThread;
+	FrameProducer* producer = new FrameProducer(broadcaster, geometry, framesPerSecond, framePool);
+	producer->moveToThread(&producerThread);
+	producerThread.start();
+
+	qint64 cpuStartUs = processCpuTimeUs();
+	QElapsedTimer wallClock;
+	wallClock.start();
+	QMetaObject::invokeMethod(producer, "start", Qt::QueuedConnection);
+	processEventsFor(static_cast<int>(durationSeconds * 1000.0));
+	QMetaObject::invokeMethod(producer, "stop", Qt::BlockingQueuedConnection);
+	double producedSeconds = wallClock.nsecsElapsed() * 1.0e-9;
+
+	// let the queues drain, frames still queued after that count as dropped
+	processEventsFor(1000);
+	qint64 cpuUs = processCpuTimeUs() - cpuStartUs;
+
+	for(BenchmarkClient* client : clients) {
+		QMetaObject::invokeMethod(client, "close", Qt::BlockingQueuedConnection);
+	}
+	QMetaObject::invokeMethod(broadcaster, "stopBroadcasting", Qt::BlockingQueuedConnection);
+	for(QThread* thread : clientThreads) {
+		thread->quit();
+		thread->wait(); // results below are read after the threads have stopped, clients and producer are deleted afterwards
+	}
+	producerThread.quit();
+	producerThread.wait();
+
+	quint64 produced = producer->producedFrames();
+	LatencyHistogram allLatencies;
+	QJsonArray clientResults;
+	quint64 totalReceived = 0;
+	quint64 totalBytes = 0;
+	quint64 totalDropped = 0;
+	for(BenchmarkClient* client : clients) {
+		quint64 received = client->receivedFrames();
+		quint64 dropped = produced > received ? produced - received : 0;
+		QJsonObject result;
+		result["read_speed_limit_mb_s"] = client->readMegabytesPerSecond();
+		result["received_frames"] = static_cast<double>(received);
+		result["dropped_frames"] = static_cast<double>(dropped);
+		result["throughput_mb_s"] = client->receivedBytes() / producedSeconds / 1.0e6;
+		result["protocol_errors"] = static_cast<double>(client->protocolErrors());
+		result["latency_us"] = latencyToJson(client->latency());
+		clientResults.append(result);
+		totalReceived += received;
+		totalBytes += client->receivedBytes();
+		totalDropped += dropped;
+		allLatencies.merge(client->latency());
+	}
+
+	QJsonObject config;
+	config["mode"] = parser.value("mode");
+	config["clients"] = clientCount;
+	config["samples_per_line"] = static_cast<double>(geometry.samplesPerLine);
+	config["lines_per_frame"] = static_cast<double>(geometry.linesPerFrame);
+	config["frames_per_buffer"] = static_cast<double>(geometry.framesPerBuffer);
+	config["bit_depth"] = geometry.bitDepth;
+	config["buffer_size_bytes"] = static_cast<double>(geometry.sizeInBytes());
+	config["target_fps"] = framesPerSecond;
+	config["duration_s"] = durationSeconds;
+	config["queue_frames"] = params.sendQueueMaxFrames;
+	config["queue_megabytes"] = params.sendQueueMaxMegabytes;
+	config["drop_policy"] = params.dropPolicy == DropPolicy::DropNewest ? "newest" : "oldest";
+	config["batch_frames"] = params.batchMaxFrames;
+	config["batch_kilobytes"] = params.batchMaxKilobytes;
+	config["batch_us"] = params.batchMaxMicroseconds;
+	config["socket_options"] = socketOptionsToJson(params.socketOptions);
+	config["sender_threads"] = params.senderThreads;
+
+	QJsonObject result;
+	result["config"] = config;
+	result["produced_frames"] = static_cast<double>(produced);
+	result["producer_skipped_frames"] = static_cast<double>(producer->skippedFrames());
+	result["produced_fps"] = produced / producedSeconds;
+	result["received_fps"] = totalReceived / producedSeconds;
+	result["throughput_mb_s"] = totalBytes / producedSeconds / 1.0e6;
+	result["dropped_frames"] = static_cast<double>(totalDropped);
+	result["latency_us"] = latencyToJson(allLatencies);
+	result["cpu_us_per_frame"] = produced > 0 ? static_cast<double>(cpuUs) / produced : 0.0;
+	result["clients"] = clientResults;
+
+	qDeleteAll(clients);
+	qDeleteAll(clientThreads);
+	delete producer;
+	broadcasterThread.quit();
+	broadcasterThread.wait();
+
+	return writeResult(parser, result);
+}
@@ -0,0 +1,170 @@
+# Reference reader for the "Shared Memory (same host)" mode of SocketStreamExtension (Linux)
+# The local socket (pipe name from the extension settings) is the control channel: right after connecting,
+# the extension sends "shared_memory_ring:<name>", the frames themselves are read from /dev/shm/<name>.
+# Frames are accessed in place with numpy, nothing is copied.
+#
+# Usage:
+#   python octproz_shared_memory_reader.py [pipe_name]
+
+import ctypes
+import mmap
+import os
+import platform
+import socket
+import struct
+import sys
+import tempfile
+import time
+
+import numpy as np
+
+RING_MAGIC = 0x5254434F
+CONTROL_FORMAT = '<I I I I Q Q Q I I I'   # magic, version, slotCount, controlSize, slotSize, slotStride, writeSequence, wakeCounter, readersWaiting, writerState
+SLOT_FORMAT = '<Q Q Q I I I I I B'        # sequence, size, timestampMs, samplesPerLine, linesPerFrame, framesPerBuffer, buffersPerVolume, currentBufferNr, bitDepth
+SLOT_HEADER_SIZE = 64
+OFFSET_WRITE_SEQUENCE = 32
+OFFSET_WAKE_COUNTER = 40
+OFFSET_WRITER_STATE = 48
+
+# futex syscall numbers, other architectures fall back to polling
+SYS_FUTEX = {'x86_64': 202, 'aarch64': 98}.get(platform.machine())
+FUTEX_WAIT = 0
+
+
+class SharedMemoryRingReader:
+    def __init__(self, ring_name):
+        self.ring_name = ring_name
+        self.mm = None
+        self.libc = ctypes.CDLL(None, use_errno=True) if SYS_FUTEX is not None else None
+        self.last_sequence = 0
+
+    def open(self):
+        fd = os.open('/dev/shm/' + self.ring_name, os.O_RDWR)
+        try:
+            self.mm = mmap.mmap(fd, 0, mmap.MAP_SHARED, mmap.PROT_READ | mmap.PROT_WRITE)
+        finally:
+            os.close(fd)
+        (magic, version, self.slot_count, self.control_size, self.slot_size, self.slot_stride,
+         write_sequence, _, _, _) = struct.unpack_from(CONTROL_FORMAT, self.mm, 0)
+        if magic != RING_MAGIC:
+            raise RuntimeError('not an OCTproZ shared memory ring')
+        self.last_sequence = write_sequence
+        # address of the mapping for futex wait, the anchor must be released before the mapping can be closed
+        self.anchor = ctypes.c_char.from_buffer(self.mm)
+        self.base_address = ctypes.addressof(self.anchor)
+        print(f"Mapped /dev/shm/{self.ring_name}: {self.slot_count} slots of {self.slot_size} bytes (version {version})")
+
+    def close(self):
+        if self.mm is not None:
+            self.anchor = None
+            self.mm.close()
+            self.mm = None
+
+    def _u32(self, offset):
+        return struct.unpack_from('<I', self.mm, offset)[0]
+
+    def _u64(self, offset):
+        return struct.unpack_from('<Q', self.mm, offset)[0]
+
+    def writer_attached(self):
+        return self._u32(OFFSET_WRITER_STATE) == 1
+
+    def wait_for_frame(self, timeout_s=1.0):
+        """Block until the writer publishes a frame newer than the last one read."""
+        deadline = time.monotonic() + timeout_s
+        while self._u64(OFFSET_WRITE_SEQUENCE) == self.last_sequence:
+            if not self.writer_attached() or time.monotonic() > deadline:
+                return False
+            wake_counter = self._u32(OFFSET_WAKE_COUNTER)
+            if self._u64(OFFSET_WRITE_SEQUENCE) != self.last_sequence:
+                break
+            if self.libc is not None:
+                # the writer wakes all waiters after every frame, the timeout only covers a writer that went away
+                timeout = struct.pack('qq', 0, 100000000)  # 100 ms
+                self.libc.syscall(SYS_FUTEX, ctypes.c_void_p(self.base_address + OFFSET_WAKE_COUNTER), FUTEX_WAIT, wake_counter, timeout, None, 0)
+            else:
+                time.sleep(0.001)
+        return True
+
+    def latest_frame(self):
+        """Return (sequence, header dict, numpy view) of the newest frame, or None if it was overwritten."""
+        sequence = self._u64(OFFSET_WRITE_SEQUENCE)
+        if sequence == 0:
+            return None
+        offset = self.control_size + ((sequence - 1) % self.slot_count) * self.slot_stride
+        fields = struct.unpack_from(SLOT_FORMAT, self.mm, offset)
+        if fields[0] != sequence:
+            return None
+        header = dict(zip(('sequence', 'size', 'timestamp_ms', 'width', 'height', 'frames_per_buffer',
+                           'buffers_per_volume', 'buffer_nr', 'bit_depth'), fields))
+        dtype = np.uint8 if header['bit_depth'] <= 8 else np.uint16 if header['bit_depth'] <= 16 else np.float32
+        data = np.frombuffer(self.mm, dtype=dtype, count=header['size'] // np.dtype(dtype).itemsize,
+                             offset=offset + SLOT_HEADER_SIZE)
+        self.last_sequence = sequence
+        return sequence, header, data, offset
+
+    def still_valid(self, sequence, offset):
+        """Seqlock check: the slot was not overwritten while the frame was being used."""
+        return self._u64(offset) == sequence
+
+
+def ring_name_from_control_channel(pipe_name):
+    path = pipe_name if os.path.isabs(pipe_name) else os.path.join(tempfile.gettempdir(), pipe_name)
+    sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    sock.connect(path)
+    line = sock.recv(4096).decode('utf-8').strip()
+    if not line.startswith('shared_memory_ring:'):
+        raise RuntimeError(f"unexpected handshake: {line}")
+    return sock, line.split(':', 1)[1]
+
+
+def main():
+    pipe_name = sys.argv[1] if len(sys.argv) > 1 else 'octproz'
+    control_sock, ring_name = ring_name_from_control_channel(pipe_name)
+    print(f"Control channel connected, ring: {ring_name}")
+
+    reader = SharedMemoryRingReader(ring_name)
+    frames = 0
+    missed = 0
+    t0 = time.monotonic()
+    try:
+        while True:
+            if reader.mm is None:
+                try:
+                    reader.open()
+                except FileNotFoundError:
+                    time.sleep(0.1)  # ring is created with the first frame
+                    continue
+            if not reader.wait_for_frame():
+                if not reader.writer_attached():
+                    print("Writer closed the ring, reopening...")
+                    frame = data = None
+                    reader.close()
+                continue
+            previous = reader.last_sequence
+            frame = reader.latest_frame()
+            if frame is None:
+                continue
+            sequence, header, data, offset = frame
+            if previous and sequence > previous + 1:
+                missed += sequence - previous - 1
+            mean = float(data[:1024].mean())  # work directly on the shared memory
+            if not reader.still_valid(sequence, offset):
+                missed += 1
+                continue
+            frames += 1
+            now = time.monotonic()
+            if now - t0 >= 1.0:
+                print(f"{frames / (now - t0):6.1f} fps, {header['width']}x{header['height']}x{header['frames_per_buffer']}, "
+                      f"{header['bit_depth']}-bit, missed {missed}, mean of first samples {mean:.1f}")
+                frames = 0
+                t0 = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        reader.close()
+        control_sock.close()
+
+
+if __name__ == '__main__':
+    main()
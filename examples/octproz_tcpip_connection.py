@@ -23,7 +23,17 @@ def main():
         'load_klin_curve:<file_path>',
         'ping',
         'enable_command_only_mode',
-        'disable_command_only_mode'
+        'disable_command_only_mode',
+        'set_decimation:every=2:fps=10',
+        'set_roi:samples=0-256:lines=0-:line_stride=4',
+        'clear_roi',
+        'set_bit_depth:bits=8:min=0:max=80',
+        'set_compression:codec=shuffle_zlib:level=1',
+        'set_volume_mode:enable=1',
+        'get_stats',
+        'set_stats_interval:5',
+        'get_latency',
+        'reset_latency'
     ]
 
     try:
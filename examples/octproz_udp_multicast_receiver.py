@@ -0,0 +1,153 @@
+# Reference receiver for the "UDP Multicast" mode of SocketStreamExtension
+# The TCP server (ip and port from the extension settings) is the control channel: right after connecting,
+# the extension sends "udp_multicast:<group>:<port>", the frames themselves are received from the multicast group.
+# Every frame is split into datagrams, each starting with a 24 byte fragment header (big-endian):
+#   magic "OCTM", frame sequence, fragment index, fragment count, frame size, fragment offset
+# A reassembled frame contains the same bytes a TCP client receives: stream header (if enabled) followed by the payload.
+#
+# Usage:
+#   python octproz_udp_multicast_receiver.py [host] [port]
+
+import socket
+import struct
+import sys
+import time
+
+FRAGMENT_MAGIC = 0x4F43544D
+FRAGMENT_FORMAT = '>I I I I I I'
+FRAGMENT_HEADER_SIZE = struct.calcsize(FRAGMENT_FORMAT)
+STREAM_START_IDENTIFIER = 299792458
+STREAM_HEADER_FORMAT = '>I I H H B'
+STREAM_HEADER_SIZE = struct.calcsize(STREAM_HEADER_FORMAT)
+STREAM_START_IDENTIFIER_V2 = 0x4F435032
+STREAM_HEADER_V2_FORMAT = '>I H H H B x Q Q I I I I I'  # identifier, version, header size, flags, bit depth, sequence, payload size, width, height, frames, buffers per volume, buffer index
+STREAM_HEADER_V2_SIZE = struct.calcsize(STREAM_HEADER_V2_FORMAT)
+MAX_PENDING_FRAMES = 4
+
+
+class FrameReassembler:
+    """Collects fragments into frames and counts frames that were lost completely or arrived incomplete."""
+
+    def __init__(self):
+        self.pending = {}
+        self.last_sequence = None
+        self.missed_frames = 0
+        self.incomplete_frames = 0
+        self.complete_frames = 0
+
+    def feed(self, datagram):
+        """Add one datagram, returns (sequence, frame bytes) when a frame is complete, otherwise None."""
+        if len(datagram) < FRAGMENT_HEADER_SIZE:
+            return None
+        magic, sequence, index, count, size, offset = struct.unpack_from(FRAGMENT_FORMAT, datagram, 0)
+        if magic != FRAGMENT_MAGIC or index >= count:
+            return None
+        if self.last_sequence is not None and sequence <= self.last_sequence:
+            return None  # late fragment of a frame that was already completed or given up
+
+        frame = self.pending.get(sequence)
+        if frame is None:
+            frame = {'data': bytearray(size), 'count': count, 'received': set()}
+            self.pending[sequence] = frame
+        data = datagram[FRAGMENT_HEADER_SIZE:]
+        frame['data'][offset:offset + len(data)] = data
+        frame['received'].add(index)
+
+        if len(frame['received']) == frame['count']:
+            self._complete(sequence)
+            return sequence, bytes(frame['data'])
+
+        # fragments of newer frames keep arriving, the oldest pending frame will not be completed anymore
+        while len(self.pending) > MAX_PENDING_FRAMES:
+            oldest = min(self.pending)
+            del self.pending[oldest]
+            self._advance(oldest, given_up=1)
+            self.incomplete_frames += 1
+        return None
+
+    def _complete(self, sequence):
+        # pending frames older than a completed one are incomplete, datagrams are not reordered by this much
+        older = [s for s in self.pending if s < sequence]
+        for s in older:
+            del self.pending[s]
+        del self.pending[sequence]
+        self.incomplete_frames += len(older)
+        self._advance(sequence, given_up=len(older) + 1)
+        self.complete_frames += 1
+
+    def _advance(self, sequence, given_up):
+        # sequence numbers between the last and this frame that were never seen at all are missed frames
+        if self.last_sequence is not None:
+            self.missed_frames += max(0, sequence - self.last_sequence - given_up)
+        self.last_sequence = sequence
+
+
+def parse_frame(frame):
+    """Split a reassembled frame into (width, height, bit depth, payload). Without stream header only the payload is known."""
+    if len(frame) >= STREAM_HEADER_V2_SIZE and struct.unpack_from('>I', frame, 0)[0] == STREAM_START_IDENTIFIER_V2:
+        (_, _, header_size, _, bit_depth, _, _, width, height, _, _, _) = struct.unpack_from(STREAM_HEADER_V2_FORMAT, frame, 0)
+        return width, height, bit_depth, frame[header_size:]
+    if len(frame) >= STREAM_HEADER_SIZE:
+        identifier, size, width, height, bit_depth = struct.unpack_from(STREAM_HEADER_FORMAT, frame, 0)
+        if identifier == STREAM_START_IDENTIFIER and size <= len(frame):
+            return width, height, bit_depth, frame[len(frame) - size:]
+    return None, None, None, frame
+
+
+def open_multicast_socket(group, port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 16 * 1024 * 1024)  # a large frame arrives as a burst of datagrams
+    sock.bind(('', port))
+    membership = struct.pack('4s4s', socket.inet_aton(group), socket.inet_aton('0.0.0.0'))
+    sock.setsockopt(socket.IPPROTO_IP, socket.IP_ADD_MEMBERSHIP, membership)
+    return sock
+
+
+def group_from_control_channel(host, port):
+    sock = socket.create_connection((host, port))
+    line = sock.recv(4096).decode('utf-8').strip()
+    if not line.startswith('udp_multicast:'):
+        raise RuntimeError(f"unexpected handshake: {line}")
+    _, group, group_port = line.split(':')
+    return sock, group, int(group_port)
+
+
+def main():
+    import numpy as np  # only needed for the statistics, the reassembly itself works on bytes
+
+    host = sys.argv[1] if len(sys.argv) > 1 else '127.0.0.1'
+    port = int(sys.argv[2]) if len(sys.argv) > 2 else 1234
+    control_sock, group, group_port = group_from_control_channel(host, port)
+    print(f"Control channel connected, multicast group: {group}:{group_port}")
+
+    sock = open_multicast_socket(group, group_port)
+    reassembler = FrameReassembler()
+    frames = 0
+    t0 = time.monotonic()
+    try:
+        while True:
+            result = reassembler.feed(sock.recv(65535))
+            if result is None:
+                continue
+            sequence, frame = result
+            width, height, bit_depth, payload = parse_frame(frame)
+            frames += 1
+            now = time.monotonic()
+            if now - t0 >= 1.0:
+                dtype = np.uint8 if (bit_depth or 8) <= 8 else np.uint16 if bit_depth <= 16 else np.float32
+                data = np.frombuffer(payload, dtype=dtype)
+                print(f"{frames / (now - t0):6.1f} fps, {width}x{height}, {bit_depth}-bit, frame {sequence}, "
+                      f"missed {reassembler.missed_frames}, incomplete {reassembler.incomplete_frames}, "
+                      f"mean of first samples {float(data[:1024].mean()):.1f}")
+                frames = 0
+                t0 = now
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.close()
+        control_sock.close()
+
+
+if __name__ == '__main__':
+    main()
@@ -1,4 +1,4 @@
-QT += core gui widgets network websockets
+QT += core gui widgets network websockets concurrent
 QMAKE_PROJECT_DEPTH = 0
 
 TARGET = socketstreamextension
@@ -29,15 +29,51 @@ DEFINES += \
 	QT_DEPRECATED_WARNINGS #emit warnings if depracted Qt features are used
 
 SOURCES += \
+	src/binarycommand.cpp \
+	src/bitdepthconverter.cpp \
 	src/broadcaster.cpp \
+	src/commandframer.cpp \
+	src/commandparsing.cpp \
+	src/framepool.cpp \
+	src/frameregion.cpp \
+	src/klincurveloader.cpp \
+	src/latencystats.cpp \
+	src/payloadcompression.cpp \
+	src/previewencoder.cpp \
+	src/qualitycontroller.cpp \
+	src/sharedmemoryring.cpp \
+	src/socketoptions.cpp \
 	src/socketstreamextension.cpp \
-	src/socketstreamextensionform.cpp 
+	src/socketstreamextensionform.cpp \
+	src/streamclient.cpp \
+	src/streamheader.cpp \
+	src/udpmulticastsender.cpp \
+	src/volumeassembler.cpp
 
 HEADERS += \
+	src/binarycommand.h \
+	src/bitdepthconverter.h \
 	src/broadcaster.h \
+	src/commanddispatcher.h \
+	src/commandframer.h \
+	src/commandparsing.h \
+	src/framepool.h \
+	src/frameregion.h \
+	src/klincurveloader.h \
+	src/latencystats.h \
+	src/payloadcompression.h \
+	src/previewencoder.h \
+	src/qualitycontroller.h \
+	src/sharedmemoryring.h \
+	src/socketoptions.h \
 	src/socketstreamextension.h \
 	src/socketstreamextensionform.h  \
-	src/socketstreamextensionparameters.h							  
+	src/socketstreamextensionparameters.h \
+	src/streamclient.h \
+	src/streamheader.h \
+	src/streamsubscription.h \
+	src/udpmulticastsender.h \
+	src/volumeassembler.h
 
 FORMS += \
 	src/socketstreamextensionform.ui
@@ -46,6 +82,11 @@ INCLUDEPATH += \
 	$$SHAREDIR \
 	src
 
+#shm_open lives in librt on older glibc versions
+unix:!macx {
+	LIBS += -lrt
+}
+
 
 
 #set system specific output directory for extension
@@ -0,0 +1,103 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "binarycommand.h"
+#include <QtEndian>
+#include <cstring>
+
+BinaryCommandReader::BinaryCommandReader(const QByteArray& payload) : payload(payload), position(0), valid(true) {
+}
+
+const char* BinaryCommandReader::take(int size) {
+	if(!this->valid || this->remaining() < size) {
+		this->valid = false;
+		return nullptr;
+	}
+	const char* data = this->payload.constData() + this->position;
+	this->position += size;
+	return data;
+}
+
+quint8 BinaryCommandReader::readU8() {
+	const char* data = this->take(1);
+	return data ? static_cast<quint8>(data[0]) : 0;
+}
+
+quint32 BinaryCommandReader::readU32() {
+	const char* data = this->take(4);
+	return data ? qFromLittleEndian<quint32>(data) : 0;
+}
+
+float BinaryCommandReader::readF32() {
+	quint32 bits = this->readU32();
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+double BinaryCommandReader::readF64() {
+	const char* data = this->take(8);
+	quint64 bits = data ? qFromLittleEndian<quint64>(data) : 0;
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+bool BinaryCommandReader::readF32Array(QVector<float>& values, quint32 count) {
+	qint64 size = static_cast<qint64>(count) * static_cast<qint64>(sizeof(float));
+	if(size > this->remaining()) {
+		this->valid = false;
+		return false;
+	}
+	const char* data = this->take(static_cast<int>(size));
+	if(!data) {
+		return false;
+	}
+	values.resize(static_cast<int>(count));
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+	memcpy(values.data(), data, static_cast<size_t>(size));
+#else
+	for(quint32 i = 0; i < count; i++) {
+		quint32 bits = qFromLittleEndian<quint32>(data + i * sizeof(float));
+		memcpy(&values[static_cast<int>(i)], &bits, sizeof(float));
+	}
+#endif
+	return true;
+}
+
+QByteArray BinaryCommand::frame(quint16 opcode, const QByteArray& payload) {
+	QByteArray frame(BINARY_COMMAND_HEADER_SIZE, Qt::Uninitialized);
+	frame[0] = static_cast<char>(BINARY_COMMAND_MARKER);
+	qToLittleEndian<quint16>(opcode, frame.data() + 1);
+	qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), frame.data() + 3);
+	return frame + payload;
+}
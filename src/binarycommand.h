@@ -0,0 +1,88 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef BINARYCOMMAND_H
+#define BINARYCOMMAND_H
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+
+// Binary command frame, an alternative to the text commands for clients that
+// send parameter updates at a high rate:
+// [u8 0x02][u16 opcode][u32 payload size][payload], all little-endian.
+// 0x02 never starts a text command, so both can be mixed on one connection.
+#define BINARY_COMMAND_MARKER 0x02
+#define BINARY_COMMAND_HEADER_SIZE 7
+
+namespace BinaryOpcode {
+	enum : quint16 {
+		Ping = 0x0001,                   // no payload, answered with "pong"
+		RemoteStart = 0x0010,            // no payload
+		RemoteStop = 0x0011,             // no payload
+		SetDispCoeff = 0x0100,           // 4 x f64, NaN leaves the coefficient unchanged
+		SetKLinCoeffs = 0x0101,          // 4 x f64, NaN leaves the coefficient unchanged
+		SetGrayscaleConversion = 0x0102, // u8 log scaling, f64 max, min, multiplicator, offset
+		SetKLinCurve = 0x0103            // u32 sample count, sample count x f32
+	};
+}
+
+// Reads the little-endian fields of a binary command payload. Reading past
+// the end returns 0 and makes the reader invalid, so a handler can read all
+// fields first and check isValid() and atEnd() once.
+class BinaryCommandReader {
+public:
+	explicit BinaryCommandReader(const QByteArray& payload);
+
+	quint8 readU8();
+	quint32 readU32();
+	float readF32();
+	double readF64();
+	bool readF32Array(QVector<float>& values, quint32 count); // false if the payload holds less than count values
+
+	bool isValid() const { return this->valid; }
+	bool atEnd() const { return this->position == this->payload.size(); }
+	int remaining() const { return this->payload.size() - this->position; }
+
+private:
+	const char* take(int size);
+
+	const QByteArray& payload;
+	int position;
+	bool valid;
+};
+
+namespace BinaryCommand {
+	QByteArray frame(quint16 opcode, const QByteArray& payload); // header and payload, as a client sends it
+}
+
+#endif // BINARYCOMMAND_H
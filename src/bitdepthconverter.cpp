@@ -0,0 +1,222 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "bitdepthconverter.h"
+
+#if defined(Q_PROCESSOR_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define BITDEPTHCONVERTER_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TARGET_AVX2 // MSVC accepts AVX2 intrinsics without /arch:AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+	template <typename In, typename Out>
+	void convertScalar(const In* input, Out* output, quint64 count, float offset, float scale, float maxValue) {
+		for(quint64 i = 0; i < count; i++) {
+			float value = (static_cast<float>(input[i]) - offset) * scale + 0.5f;
+			value = value > 0.0f ? value : 0.0f; // also maps NaN to 0
+			value = value < maxValue ? value : maxValue;
+			output[i] = static_cast<Out>(value);
+		}
+	}
+
+#ifdef BITDEPTHCONVERTER_X86
+	bool cpuSupportsAvx2() {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if(info[0] < 7) {
+			return false;
+		}
+		__cpuid(info, 1);
+		bool osSavesAvxState = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+		if(!osSavesAvxState) {
+			return false;
+		}
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	inline __m128i windowSse2(const float* input, __m128 offset, __m128 scale, __m128 maxValue) {
+		__m128 value = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(input), offset), scale), _mm_set1_ps(0.5f));
+		value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), maxValue); // max_ps returns the second operand for NaN
+		return _mm_cvttps_epi32(value);
+	}
+
+	void convertFloatToUInt8Sse2(const float* input, quint8* output, quint64 count, float offset, float scale) {
+		__m128 offsetVector = _mm_set1_ps(offset);
+		__m128 scaleVector = _mm_set1_ps(scale);
+		__m128 maxVector = _mm_set1_ps(255.0f);
+		quint64 i = 0;
+		for(; i + 16 <= count; i += 16) {
+			__m128i a = windowSse2(input + i, offsetVector, scaleVector, maxVector);
+			__m128i b = windowSse2(input + i + 4, offsetVector, scaleVector, maxVector);
+			__m128i c = windowSse2(input + i + 8, offsetVector, scaleVector, maxVector);
+			__m128i d = windowSse2(input + i + 12, offsetVector, scaleVector, maxVector);
+			__m128i packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+		}
+		convertScalar(input + i, output + i, count - i, offset, scale, 255.0f);
+	}
+
+	void convertFloatToUInt16Sse2(const float* input, quint16* output, quint64 count, float offset, float scale) {
+		__m128 offsetVector = _mm_set1_ps(offset);
+		__m128 scaleVector = _mm_set1_ps(scale);
+		__m128 maxVector = _mm_set1_ps(65535.0f);
+		// SSE2 has no unsigned 32 to 16-bit pack, so values are shifted into the signed range and back
+		__m128i bias32 = _mm_set1_epi32(32768);
+		__m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+		quint64 i = 0;
+		for(; i + 8 <= count; i += 8) {
+			__m128i a = _mm_sub_epi32(windowSse2(input + i, offsetVector, scaleVector, maxVector), bias32);
+			__m128i b = _mm_sub_epi32(windowSse2(input + i + 4, offsetVector, scaleVector, maxVector), bias32);
+			__m128i packed = _mm_xor_si128(_mm_packs_epi32(a, b), bias16);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+		}
+		convertScalar(input + i, output + i, count - i, offset, scale, 65535.0f);
+	}
+
+	TARGET_AVX2 inline __m256i windowAvx2(const float* input, __m256 offset, __m256 scale, __m256 maxValue) {
+		__m256 value = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(input), offset), scale), _mm256_set1_ps(0.5f));
+		value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), maxValue);
+		return _mm256_cvttps_epi32(value);
+	}
+
+	TARGET_AVX2 void convertFloatToUInt8Avx2(const float* input, quint8* output, quint64 count, float offset, float scale) {
+		__m256 offsetVector = _mm256_set1_ps(offset);
+		__m256 scaleVector = _mm256_set1_ps(scale);
+		__m256 maxVector = _mm256_set1_ps(255.0f);
+		// the pack instructions work per 128-bit lane, this permutation restores the sample order afterwards
+		__m256i laneOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		quint64 i = 0;
+		for(; i + 32 <= count; i += 32) {
+			__m256i a = windowAvx2(input + i, offsetVector, scaleVector, maxVector);
+			__m256i b = windowAvx2(input + i + 8, offsetVector, scaleVector, maxVector);
+			__m256i c = windowAvx2(input + i + 16, offsetVector, scaleVector, maxVector);
+			__m256i d = windowAvx2(input + i + 24, offsetVector, scaleVector, maxVector);
+			__m256i packed = _mm256_packus_epi16(_mm256_packus_epi32(a, b), _mm256_packus_epi32(c, d));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_permutevar8x32_epi32(packed, laneOrder));
+		}
+		convertScalar(input + i, output + i, count - i, offset, scale, 255.0f);
+	}
+
+	TARGET_AVX2 void convertFloatToUInt16Avx2(const float* input, quint16* output, quint64 count, float offset, float scale) {
+		__m256 offsetVector = _mm256_set1_ps(offset);
+		__m256 scaleVector = _mm256_set1_ps(scale);
+		__m256 maxVector = _mm256_set1_ps(65535.0f);
+		quint64 i = 0;
+		for(; i + 16 <= count; i += 16) {
+			__m256i a = windowAvx2(input + i, offsetVector, scaleVector, maxVector);
+			__m256i b = windowAvx2(input + i + 8, offsetVector, scaleVector, maxVector);
+			__m256i packed = _mm256_packus_epi32(a, b);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_permute4x64_epi64(packed, 0xD8));
+		}
+		convertScalar(input + i, output + i, count - i, offset, scale, 65535.0f);
+	}
+#endif
+
+	bool useAvx2() {
+#ifdef BITDEPTHCONVERTER_X86
+		static const bool supported = cpuSupportsAvx2();
+		return supported;
+#else
+		return false;
+#endif
+	}
+
+	template <typename Out>
+	void convertFloat(const float* input, Out* output, quint64 count, float offset, float scale, float maxValue) {
+		convertScalar(input, output, count, offset, scale, maxValue);
+	}
+
+#ifdef BITDEPTHCONVERTER_X86
+	template <>
+	void convertFloat<quint8>(const float* input, quint8* output, quint64 count, float offset, float scale, float) {
+		if(useAvx2()) {
+			convertFloatToUInt8Avx2(input, output, count, offset, scale);
+		} else {
+			convertFloatToUInt8Sse2(input, output, count, offset, scale);
+		}
+	}
+
+	template <>
+	void convertFloat<quint16>(const float* input, quint16* output, quint64 count, float offset, float scale, float) {
+		if(useAvx2()) {
+			convertFloatToUInt16Avx2(input, output, count, offset, scale);
+		} else {
+			convertFloatToUInt16Sse2(input, output, count, offset, scale);
+		}
+	}
+#endif
+
+	template <typename Out>
+	void convertTo(const void* input, quint8 inputBitDepth, Out* output, quint64 count, float offset, float scale, float maxValue) {
+		if(inputBitDepth > 16) {
+			convertFloat(static_cast<const float*>(input), output, count, offset, scale, maxValue);
+		} else if(inputBitDepth > 8) {
+			convertScalar(static_cast<const quint16*>(input), output, count, offset, scale, maxValue);
+		} else {
+			convertScalar(static_cast<const quint8*>(input), output, count, offset, scale, maxValue);
+		}
+	}
+}
+
+bool BitDepthConverter::reducesBitDepth(quint8 inputBitDepth, quint8 outputBitDepth) {
+	return (outputBitDepth == 8 || outputBitDepth == 16) && outputBitDepth < inputBitDepth && inputBitDepth <= 32;
+}
+
+void BitDepthConverter::convert(const void* input, quint8 inputBitDepth, void* output, quint8 outputBitDepth, quint64 sampleCount, float windowMin, float windowMax) {
+	float maxValue = outputBitDepth == 8 ? 255.0f : 65535.0f;
+	float scale = windowMax > windowMin ? maxValue / (windowMax - windowMin) : 0.0f;
+	if(outputBitDepth == 8) {
+		convertTo(input, inputBitDepth, static_cast<quint8*>(output), sampleCount, windowMin, scale, maxValue);
+	} else {
+		convertTo(input, inputBitDepth, static_cast<quint16*>(output), sampleCount, windowMin, scale, maxValue);
+	}
+}
+
+const char* BitDepthConverter::instructionSet() {
+#ifdef BITDEPTHCONVERTER_X86
+	return useAvx2() ? "AVX2" : "SSE2";
+#else
+	return "scalar";
+#endif
+}
@@ -0,0 +1,48 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef BITDEPTHCONVERTER_H
+#define BITDEPTHCONVERTER_H
+
+#include <QtGlobal>
+
+// Maps samples linearly from the window [windowMin, windowMax] to 8- or 16-bit
+// unsigned integers, values outside of the window are clamped. 32-bit input is
+// float, 9 to 16-bit input is quint16. Float input uses AVX2 or SSE2 kernels if
+// the CPU supports them. Input and output may be the same buffer.
+namespace BitDepthConverter {
+	bool reducesBitDepth(quint8 inputBitDepth, quint8 outputBitDepth);
+	void convert(const void* input, quint8 inputBitDepth, void* output, quint8 outputBitDepth, quint64 sampleCount, float windowMin, float windowMax);
+	const char* instructionSet();
+}
+
+#endif // BITDEPTHCONVERTER_H
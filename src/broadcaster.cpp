@@ -32,91 +32,130 @@
 
 #include "broadcaster.h"
 #include "socketstreamextensionparameters.h"
+#include "commandparsing.h"
+#include "streamheader.h"
+#include "bitdepthconverter.h"
 #include <QHostAddress>
-#include <QDataStream>
 #include <QDateTime>
-#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtNumeric>
 
-quint32 Broadcaster::startIdentifier = 299792458; // identifier (magic number) for synchronization on client side
-
-Broadcaster::Broadcaster(QObject* parent) : QObject(parent), tcpServer(nullptr), localServer(nullptr), webSocketServer(nullptr), tag("[Socket Stream Extension] - "), isBroadcasting(false) {
+Broadcaster::Broadcaster(QObject* parent) : QObject(parent), tcpServer(nullptr), localServer(nullptr), webSocketServer(nullptr), latencyStats(new LatencyStats()), nextClientId(1), framesBroadcast(0), sourceBitDepth(0), frameSizeInBytes(0), statsTimer(nullptr), statsTick(0), sharedMemoryErrorReported(false), headerTruncationReported(false), socketOptionsErrorReported(false), multicastSender(nullptr), multicastThread(nullptr), tag("[Socket Stream Extension] - "), isBroadcasting(false) {
+	this->registerCommands();
 }
 
 Broadcaster::~Broadcaster() {
 	this->stopBroadcasting();
+	this->stopSenderThreads();
 }
 
-void Broadcaster::configure(const SocketStreamExtensionParameters params) {
-	this->stopBroadcasting();
+bool Broadcaster::updateListeners() {
+	// the transport selected by mode is always served, the listen flags add further transports next to it.
+	// Servers of transports that were switched off are closed together with their clients, all other clients stay connected
+	bool tcpEnabled = this->params.mode == CommunicationMode::TCPIP || this->params.mode == CommunicationMode::UdpMulticast || this->params.listenTcp;
+	bool localEnabled = this->params.mode == CommunicationMode::IPC || this->params.mode == CommunicationMode::SharedMemory || this->params.listenIpc;
+	bool webSocketEnabled = this->params.mode == CommunicationMode::WebSocket || this->params.listenWebSocket;
 
-	if(this->tcpServer) {
-		this->tcpServer->deleteLater();
-		this->tcpServer = nullptr;
+	if(tcpEnabled && !this->tcpServer) {
+		this->tcpServer = new QTcpServer(this);
+		connect(this->tcpServer, &QTcpServer::newConnection, this, &Broadcaster::onClientConnected);
+		if(this->tcpServer->listen(QHostAddress(this->params.ip), this->params.port)) {
+			emit info(this->tag + tr("Listening for TCP/IP clients on %1:%2").arg(this->params.ip).arg(this->params.port));
+		} else {
+			emit error(this->tag + tr("TCP/IP: %1").arg(this->tcpServer->errorString()));
+			this->closeServer(this->tcpServer, "tcp");
+		}
+	} else if(!tcpEnabled && this->tcpServer) {
+		this->closeServer(this->tcpServer, "tcp");
 	}
-	if(this->localServer) {
-		this->localServer->deleteLater();
-		this->localServer = nullptr;
+
+	if(localEnabled && !this->localServer) {
+		this->localServer = new QLocalServer(this);
+		connect(this->localServer, &QLocalServer::newConnection, this, &Broadcaster::onClientConnected);
+		if(this->localServer->listen(this->params.pipeName)) {
+			emit info(this->tag + tr("Listening for local clients on %1").arg(this->localServer->fullServerName()));
+		} else {
+			emit error(this->tag + tr("IPC: %1").arg(this->localServer->errorString()));
+			this->closeServer(this->localServer, "ipc");
+		}
+	} else if(!localEnabled && this->localServer) {
+		this->closeServer(this->localServer, "ipc");
 	}
-	if(this->webSocketServer) {
-		this->webSocketServer->deleteLater();
-		this->webSocketServer = nullptr;
+
+	if(webSocketEnabled && !this->webSocketServer) {
+		this->webSocketServer = new QWebSocketServer(QStringLiteral("Broadcaster WebSocket Server"), QWebSocketServer::NonSecureMode, this);
+		connect(this->webSocketServer, &QWebSocketServer::newConnection, this, &Broadcaster::onWebSocketConnected);
+		if(this->webSocketServer->listen(QHostAddress::Any, this->params.webSocketPort)) {
+			emit info(this->tag + tr("Listening for WebSocket clients on port %1").arg(this->params.webSocketPort));
+			this->reportSocketOptionFailures(SocketTuning::applyToListener(this->webSocketServer->socketDescriptor(), this->params.socketOptions), "WebSocket");
+		} else {
+			emit error(this->tag + tr("WebSocket: %1").arg(this->webSocketServer->errorString()));
+			this->closeServer(this->webSocketServer, "websocket");
+		}
+	} else if(!webSocketEnabled && this->webSocketServer) {
+		this->closeServer(this->webSocketServer, "websocket");
 	}
 
-	this->params = params;
-	switch(this->params.mode) {
-		case CommunicationMode::TCPIP:
-			this->tcpServer = new QTcpServer(this);
-			connect(this->tcpServer, &QTcpServer::newConnection, this, &Broadcaster::onClientConnected);
-			break;
-		case CommunicationMode::IPC:
-			this->localServer = new QLocalServer(this);
-			connect(this->localServer, &QLocalServer::newConnection, this, &Broadcaster::onClientConnected);
-			break;
-		case CommunicationMode::WebSocket:
-			this->webSocketServer = new QWebSocketServer(QStringLiteral("Broadcaster WebSocket Server"), QWebSocketServer::NonSecureMode, this);
-			connect(this->webSocketServer, &QWebSocketServer::newConnection, this, &Broadcaster::onWebSocketConnected);
-			break;
-		default:
-			qWarning() << "Unknown Communication Mode!";
-			break;
+	return this->tcpServer || this->localServer || this->webSocketServer;
+}
+
+template<typename Server>
+void Broadcaster::closeServer(Server*& server, const QString& transport) {
+	server->close();
+	server->deleteLater();
+	server = nullptr;
+
+	const QList<StreamClient*> clients = this->commandConnections + this->dataConnections;
+	for(StreamClient* client : clients) {
+		if(client->transportName() == transport) {
+			this->removeClient(client);
+			QMetaObject::invokeMethod(client, "close");
+			client->deleteLater();
+		}
 	}
 }
 
+void Broadcaster::removeClient(StreamClient* client) {
+	this->commandConnections.removeAll(client);
+	this->dataConnections.removeAll(client);
+	this->clientThreads.remove(client);
+	this->subscriptions.remove(client);
+	this->clientStats.remove(client);
+	this->updateFramePoolSize();
+}
+
 void Broadcaster::startBroadcasting() {
-	this->configure(this->params);
-
-	switch(this->params.mode) {
-		case CommunicationMode::TCPIP:
-			if(tcpServer) {
-				if(!this->tcpServer->listen(QHostAddress(this->params.ip), this->params.port)) {
-					emit error(this->tcpServer->errorString());
-					return;
-				}
-			}
-			break;
-		case CommunicationMode::IPC:
-			if(localServer) {
-				if(!this->localServer->listen(this->params.pipeName)) {
-					emit error(this->localServer->errorString());
-					return;
-				}
-			}
-			break;
-		case CommunicationMode::WebSocket:
-			if(webSocketServer) {
-				if(!this->webSocketServer->listen(QHostAddress::Any, this->params.port)) { // WebSocket typically listens on a port
-					emit error(this->webSocketServer->errorString());
-					return;
-				}
-			}
-			break;
-		default:
-			qWarning() << "Unknown Communication Mode!";
+	this->stopBroadcasting();
+	if(this->params.mode == CommunicationMode::SharedMemory) {
+		if(!SharedMemoryRing::isSupported()) {
+			emit error(this->tag + tr("Shared memory mode is only available on Unix systems."));
 			return;
+		}
+		// the ring itself is created with the first frame, when the buffer size is known
+		this->sharedMemoryErrorReported = false;
+	}
+
+	this->setupSenderThreads(this->params.senderThreads);
+	if(!this->statsTimer) {
+		// created here and not in the constructor, so that the timer lives in the broadcaster thread
+		this->statsTimer = new QTimer(this);
+		connect(this->statsTimer, &QTimer::timeout, this, &Broadcaster::updateStats);
 	}
+	this->statsClock.start();
+	this->statsTimer->start(1000);
 
-	this->isBroadcasting = true;
-	emit listeningEnabled(true);
+	// broadcasting runs as long as at least one transport listens, the others have reported their error
+	this->isBroadcasting = this->updateListeners();
+	if(this->isBroadcasting) {
+		if(this->params.mode == CommunicationMode::UdpMulticast) {
+			this->openMulticastSender();
+		}
+		emit listeningEnabled(true);
+	} else {
+		this->statsTimer->stop();
+	}
 }
 
 void Broadcaster::stopBroadcasting() {
@@ -124,72 +163,96 @@ void Broadcaster::stopBroadcasting() {
 		return;
 	}
 
-	for(QObject* connection : qAsConst(this->commandConnections)) {
-		if(auto ioDevice = qobject_cast<QIODevice*>(connection)) {
-			ioDevice->close();
-		} else if(auto webSocket = qobject_cast<QWebSocket*>(connection)) {
-			webSocket->close();
-		}
-		connection->deleteLater();
+	// clear the lists before closing, closing a socket emits disconnected() which would modify them while iterating
+	const QList<StreamClient*> clients = this->commandConnections + this->dataConnections;
+	for(StreamClient* client : clients) {
+		this->removeClient(client);
 	}
-	this->commandConnections.clear();
-
-	for(QObject* connection : qAsConst(this->dataConnections)) {
-		if(auto ioDevice = qobject_cast<QIODevice*>(connection)) {
-			ioDevice->close();
-		} else if(auto webSocket = qobject_cast<QWebSocket*>(connection)) {
-			webSocket->close();
-		}
-		connection->deleteLater();
+	if(this->statsTimer) {
+		this->statsTimer->stop();
 	}
-	this->dataConnections.clear();
-
-	if(this->tcpServer && this->tcpServer->isListening()) {
-		this->tcpServer->close();
-		this->isBroadcasting = false;
+	for(StreamClient* client : clients) {
+		QMetaObject::invokeMethod(client, "close");
+		client->deleteLater();
 	}
-	if(this->localServer && this->localServer->isListening()) {
-		this->localServer->close();
-		this->isBroadcasting = false;
+
+	if(this->tcpServer) {
+		this->closeServer(this->tcpServer, "tcp");
 	}
-	if(this->webSocketServer && this->webSocketServer->isListening()) {
-		this->webSocketServer->close();
-		this->isBroadcasting = false;
+	if(this->localServer) {
+		this->closeServer(this->localServer, "ipc");
 	}
-	if(!this->isBroadcasting) {
-		emit info(this->tag + tr("Broadcasting stopped!"));
-		emit listeningEnabled(false);
+	if(this->webSocketServer) {
+		this->closeServer(this->webSocketServer, "websocket");
 	}
+	this->sharedMemoryRing.destroy();
+	this->closeMulticastSender();
+
+	this->isBroadcasting = false;
+	emit info(this->tag + tr("Broadcasting stopped!"));
+	emit listeningEnabled(false);
 }
 
 void Broadcaster::setParams(const SocketStreamExtensionParameters params) {
+	bool transportsChanged = params.listenTcp != this->params.listenTcp || params.listenIpc != this->params.listenIpc || params.listenWebSocket != this->params.listenWebSocket;
+	bool socketOptionsChanged = params.socketOptions != this->params.socketOptions;
 	this->params = params;
+	if(socketOptionsChanged) {
+		// connected clients keep the options they were accepted with, only corking follows the setting right away
+		this->socketOptionsErrorReported = false;
+		if(this->webSocketServer) {
+			this->reportSocketOptionFailures(SocketTuning::applyToListener(this->webSocketServer->socketDescriptor(), this->params.socketOptions), "WebSocket");
+		}
+	}
+	for(StreamClient* client : qAsConst(this->dataConnections)) {
+		this->applyQueueLimits(client);
+	}
+	for(StreamClient* client : qAsConst(this->commandConnections)) {
+		this->applyQueueLimits(client);
+	}
+	this->updateFramePoolSize();
+
+	// additional transports can be switched on and off while broadcasting without interrupting the clients of the other transports
+	if(this->isBroadcasting && transportsChanged && !this->updateListeners()) {
+		this->stopBroadcasting();
+	}
 }
 
 void Broadcaster::onClientConnected() {
+	// several servers can be listening at the same time, the sender tells which one has the pending connection
 	QIODevice* newConnection = nullptr;
-	if(this->params.mode == CommunicationMode::TCPIP && this->tcpServer) {
-		newConnection = this->tcpServer->nextPendingConnection();
-	} else if(this->params.mode == CommunicationMode::IPC && this->localServer) {
-		newConnection = this->localServer->nextPendingConnection();
+	bool isLocalConnection = false;
+	bool isTcpConnection = false;
+	if(this->tcpServer && sender() == this->tcpServer) {
+		QTcpSocket* tcpSocket = this->tcpServer->nextPendingConnection();
+		if(tcpSocket) {
+			this->reportSocketOptionFailures(SocketTuning::apply(tcpSocket, this->params.socketOptions), "TCP/IP");
+		}
+		newConnection = tcpSocket;
+		isTcpConnection = true;
+	} else if(this->localServer && sender() == this->localServer) {
+		QLocalSocket* localSocket = this->localServer->nextPendingConnection();
+		if(localSocket) {
+			this->reportSocketOptionFailures(SocketTuning::apply(localSocket, this->params.socketOptions), "IPC");
+		}
+		newConnection = localSocket;
+		isLocalConnection = true;
 	}
 
 	if(newConnection) {
-		connect(newConnection, &QIODevice::readyRead, this, &Broadcaster::readyRead);
-
-		if(this->params.mode == CommunicationMode::TCPIP) {
-			QTcpSocket* tcpSocket = static_cast<QTcpSocket*>(newConnection);
-			connect(tcpSocket, &QTcpSocket::disconnected, this, &Broadcaster::onClientDisconnected);
-			if(this->params.tcpNoDelay) {
-				tcpSocket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
-			}
-			tcpConnections.append(tcpSocket);
-		} else if(this->params.mode == CommunicationMode::IPC) {
-			connect(static_cast<QLocalSocket*>(newConnection), &QLocalSocket::disconnected, this, &Broadcaster::onClientDisconnected);
-			localConnections.append(static_cast<QLocalSocket*>(newConnection));
+		if(isLocalConnection && this->params.mode == CommunicationMode::SharedMemory) {
+			// in shared memory mode the local socket is the control channel. Frames are read from the ring, so the client starts in command only mode
+			StreamClient* client = new StreamClient(newConnection);
+			this->addClient(client, false);
+			this->sendToClient(client, QString("shared_memory_ring:%1\n").arg(this->sharedMemoryName()));
+		} else if(isTcpConnection && this->params.mode == CommunicationMode::UdpMulticast) {
+			// in multicast mode the tcp connection is the control channel, frames are received from the multicast group
+			StreamClient* client = new StreamClient(newConnection);
+			this->addClient(client, false);
+			this->sendToClient(client, QString("udp_multicast:%1:%2\n").arg(this->params.multicastGroup).arg(this->params.multicastPort));
+		} else {
+			this->addClient(new StreamClient(newConnection), true);
 		}
-
-		dataConnections.append(static_cast<QObject*>(newConnection));
 		emit info(this->tag + tr("Client connected!"));
 	}
 }
@@ -198,138 +261,896 @@ void Broadcaster::onWebSocketConnected() {
 	if(!webSocketServer)
 		return;
 
-	QWebSocket* client = webSocketServer->nextPendingConnection();
+	QWebSocket* webSocket = webSocketServer->nextPendingConnection();
+	if(webSocket) {
+		this->addClient(new StreamClient(webSocket), true);
+		emit info(this->tag + tr("WebSocket client connected!"));
+	}
+}
 
-	connect(client, &QWebSocket::binaryMessageReceived, this, &Broadcaster::onBinaryMessageReceived);
-	connect(client, &QWebSocket::textMessageReceived, this, &Broadcaster::onTextMessageReceived);
-	connect(client, &QWebSocket::disconnected, this, &Broadcaster::onWebSocketDisconnected);
+void Broadcaster::addClient(StreamClient* client, bool receivesData) {
+	// each client writes from its own sender thread, so a socket that drains slowly does not hold up the other clients or the command handling here
+	client->setLatencyStats(this->latencyStats);
+	QThread* senderThread = this->leastLoadedSenderThread();
+	if(senderThread) {
+		client->moveToThread(senderThread);
+		this->clientThreads.insert(client, senderThread);
+	}
+	this->applyQueueLimits(client);
+	this->subscriptions.insert(client, StreamSubscription());
+	ClientStats stats;
+	stats.id = this->nextClientId++;
+	this->clientStats.insert(client, stats);
+	connect(client, &StreamClient::messageReceived, this, &Broadcaster::onClientMessageReceived);
+	connect(client, &StreamClient::binaryCommandReceived, this, &Broadcaster::onClientBinaryCommandReceived);
+	connect(client, &StreamClient::disconnected, this, &Broadcaster::onClientDisconnected);
+	connect(client, &StreamClient::error, this, [this](const QString message) {
+		emit error(this->tag + message);
+	});
+	if(receivesData) {
+		this->dataConnections.append(client);
+	} else {
+		this->commandConnections.append(client);
+	}
+	this->updateFramePoolSize();
+}
 
-	dataConnections.append(static_cast<QObject*>(client));
-	webSocketConnections.append(client);
+void Broadcaster::applyQueueLimits(StreamClient* client) {
+	qint64 maxBytes = static_cast<qint64>(this->params.sendQueueMaxMegabytes) * 1024 * 1024;
+	QMetaObject::invokeMethod(client, "setQueueLimits", Q_ARG(int, this->params.sendQueueMaxFrames), Q_ARG(qint64, maxBytes), Q_ARG(DropPolicy, this->params.dropPolicy));
+	qint64 batchMaxBytes = static_cast<qint64>(this->params.batchMaxKilobytes) * 1024;
+	QMetaObject::invokeMethod(client, "setBatchLimits", Q_ARG(int, this->params.batchMaxFrames), Q_ARG(qint64, batchMaxBytes), Q_ARG(int, this->params.batchMaxMicroseconds));
+	QMetaObject::invokeMethod(client, "setCorking", Q_ARG(bool, this->params.socketOptions.cork));
+}
 
-	emit info(this->tag + tr("WebSocket client connected!"));
+void Broadcaster::updateFramePoolSize() {
+	// every holder of a frame needs its own slots: if the pool runs out, the buffer is skipped for all clients, so one slow client with a full queue would cost the others frames
+	if(this->framePool.isNull()) {
+		return;
+	}
+	// a queue never holds more frames than fit into its byte budget (but always one), so large buffers do not reserve sendQueueMaxFrames slots per client
+	int queuedFrames = qMax(1, this->params.sendQueueMaxFrames);
+	qint64 maxQueuedBytes = static_cast<qint64>(this->params.sendQueueMaxMegabytes) * 1024 * 1024;
+	if(maxQueuedBytes > 0 && this->frameSizeInBytes > 0) {
+		qint64 framesInBudget = (maxQueuedBytes + static_cast<qint64>(this->frameSizeInBytes) - 1) / static_cast<qint64>(this->frameSizeInBytes);
+		queuedFrames = static_cast<int>(qBound<qint64>(1, framesInBudget, queuedFrames));
+	}
+	int slots = FRAME_POOL_PIPELINE_SLOTS + qMax(1, this->dataConnections.size()) * (queuedFrames + FRAME_POOL_CLIENT_IN_FLIGHT);
+	if(this->multicastSender) {
+		slots += UDP_MAX_FRAMES_IN_FLIGHT;
+	}
+	this->framePool->setSlotCount(slots);
 }
 
-void Broadcaster::onWebSocketDisconnected() {
-	QWebSocket* disconnectedClient = qobject_cast<QWebSocket*>(sender());
-	if(disconnectedClient) {
-		webSocketConnections.removeAll(disconnectedClient);
-		dataConnections.removeAll(static_cast<QObject*>(disconnectedClient));
-		commandConnections.removeAll(static_cast<QObject*>(disconnectedClient));
-		disconnectedClient->deleteLater();
-		emit info(this->tag + tr("WebSocket client disconnected."));
+void Broadcaster::reportSocketOptionFailures(const QStringList& failed, const QString& transport) {
+	if(failed.isEmpty() || this->socketOptionsErrorReported) {
+		return;
 	}
+	emit error(this->tag + tr("%1: socket options not supported on this platform or rejected by the system: %2").arg(transport, failed.join(", ")));
+	this->socketOptionsErrorReported = true;
+}
+
+void Broadcaster::sendToClient(StreamClient* client, const QString& text) {
+	QMetaObject::invokeMethod(client, "sendText", Q_ARG(QString, text));
+}
+
+void Broadcaster::setupSenderThreads(int count) {
+	count = qMax(0, count);
+	if(count == this->senderThreads.size()) {
+		return;
+	}
+	this->stopSenderThreads();
+	for(int i = 0; i < count; i++) {
+		QThread* thread = new QThread(this);
+		thread->setObjectName(QString("SocketStreamSender%1").arg(i));
+		thread->start();
+		this->senderThreads.append(thread);
+	}
+}
+
+void Broadcaster::stopSenderThreads() {
+	// clients that still live in these threads are deleted when their thread finishes
+	for(QThread* thread : qAsConst(this->senderThreads)) {
+		thread->quit();
+		thread->wait();
+		delete thread;
+	}
+	this->senderThreads.clear();
+	this->clientThreads.clear();
+}
+
+QThread* Broadcaster::leastLoadedSenderThread() const {
+	QThread* leastLoaded = nullptr;
+	int leastClients = 0;
+	for(QThread* thread : this->senderThreads) {
+		int clients = 0;
+		for(QThread* clientThread : this->clientThreads) {
+			if(clientThread == thread) {
+				clients++;
+			}
+		}
+		if(!leastLoaded || clients < leastClients) {
+			leastLoaded = thread;
+			leastClients = clients;
+		}
+	}
+	return leastLoaded;
 }
 
 void Broadcaster::onClientDisconnected() {
-	QIODevice* disconnectedDevice = qobject_cast<QIODevice*>(sender());
-	if(disconnectedDevice) {
-		commandConnections.removeAll(static_cast<QObject*>(disconnectedDevice));
-		dataConnections.removeAll(static_cast<QObject*>(disconnectedDevice));
-		if(this->params.mode == CommunicationMode::TCPIP) {
-			tcpConnections.removeAll(static_cast<QTcpSocket*>(disconnectedDevice));
-		} else if(this->params.mode == CommunicationMode::IPC) {
-			localConnections.removeAll(static_cast<QLocalSocket*>(disconnectedDevice));
+	StreamClient* client = static_cast<StreamClient*>(sender());
+	if(client && (this->dataConnections.contains(client) || this->commandConnections.contains(client))) {
+		this->removeClient(client);
+		if(client->droppedFrames() > 0) {
+			emit info(this->tag + tr("Client disconnected. %1 frames were dropped because the client could not keep up.").arg(client->droppedFrames()));
+		} else {
+			emit info(this->tag + tr("Client disconnected."));
 		}
-		disconnectedDevice->deleteLater();
-		emit info(this->tag + tr("Client disconnected."));
+		client->deleteLater();
 	}
 }
 
-void Broadcaster::onBinaryMessageReceived(const QByteArray& message) {
-	QWebSocket* webSocket = qobject_cast<QWebSocket*>(sender());
-	if(webSocket) {
-		QString dataString = QString::fromUtf8(message).trimmed();
-		processIncomingMessage(dataString, static_cast<QObject*>(webSocket));
+void Broadcaster::onClientMessageReceived(const QString& message) {
+	// the message may have been queued by a client that has disconnected and been removed in the meantime
+	StreamClient* client = static_cast<StreamClient*>(sender());
+	if(client && (this->dataConnections.contains(client) || this->commandConnections.contains(client))) {
+		processIncomingMessage(message, client);
 	}
 }
 
-void Broadcaster::onTextMessageReceived(const QString& message) {
-	QWebSocket* webSocket = qobject_cast<QWebSocket*>(sender());
-	if(webSocket) {
-		QString dataString = message.trimmed();
-		processIncomingMessage(dataString, static_cast<QObject*>(webSocket));
+void Broadcaster::processIncomingMessage(const QString& dataString, StreamClient* client) {
+	if(!client) {
+		emit error(this->tag + "Received a message from a null device.");
+		return;
+	}
+	if(!this->commands.dispatchText(client, dataString)) {
+		emit remoteCommandReceived(dataString);
 	}
 }
 
-void Broadcaster::readyRead() {
-	QIODevice* senderDevice = qobject_cast<QIODevice*>(sender());
-	if(senderDevice) {
-		QByteArray data = senderDevice->readAll();
-		QString dataString = QString::fromUtf8(data).trimmed();
-		processIncomingMessage(dataString, static_cast<QObject*>(senderDevice));
+void Broadcaster::onClientBinaryCommandReceived(quint16 opcode, const QByteArray& payload) {
+	StreamClient* client = static_cast<StreamClient*>(sender());
+	if(client && (this->dataConnections.contains(client) || this->commandConnections.contains(client))) {
+		if(!this->commands.dispatchBinary(client, opcode, payload)) {
+			emit remoteBinaryCommandReceived(opcode, payload);
+		}
 	}
 }
 
-void Broadcaster::processIncomingMessage(const QString& dataString, QObject* device) {
-	if(!device) {
-		emit error(this->tag + "Received a message from a null device.");
+void Broadcaster::registerCommands() {
+	this->commands.addTextCommand("ping", [this](StreamClient* client, const QString&) {
+		this->sendToClient(client, "pong\n");
+	}, CommandMatch::Exact);
+	this->commands.addBinaryCommand(BinaryOpcode::Ping, [this](StreamClient* client, BinaryCommandReader&) {
+		this->sendToClient(client, "pong\n");
+	});
+	this->commands.addTextCommand("enable_command_only_mode", [this](StreamClient* client, const QString&) {
+		if(this->dataConnections.contains(client)) {
+			this->dataConnections.removeAll(client);
+			this->commandConnections.append(client);
+			this->updateFramePoolSize();
+			this->sendToClient(client, "Command mode enabled.\n");
+		}
+	}, CommandMatch::Exact);
+	this->commands.addTextCommand("disable_command_only_mode", [this](StreamClient* client, const QString&) {
+		if(this->commandConnections.contains(client)) {
+			this->commandConnections.removeAll(client);
+			this->dataConnections.append(client);
+			this->updateFramePoolSize();
+			this->sendToClient(client, "Command mode disabled.\n");
+		}
+	}, CommandMatch::Exact);
+	this->commands.addTextCommand("set_decimation", [this](StreamClient* client, const QString& command) {
+		this->handleSetDecimationCommand(client, command);
+	});
+	this->commands.addTextCommand("set_roi", [this](StreamClient* client, const QString& command) {
+		this->handleSetRoiCommand(client, command);
+	});
+	this->commands.addTextCommand("set_bit_depth", [this](StreamClient* client, const QString& command) {
+		this->handleSetBitDepthCommand(client, command);
+	});
+	this->commands.addTextCommand("set_compression", [this](StreamClient* client, const QString& command) {
+		this->handleSetCompressionCommand(client, command);
+	});
+	this->commands.addTextCommand("set_volume_mode", [this](StreamClient* client, const QString& command) {
+		this->handleSetVolumeModeCommand(client, command);
+	});
+	this->commands.addTextCommand("set_preview", [this](StreamClient* client, const QString& command) {
+		this->handleSetPreviewCommand(client, command);
+	});
+	this->commands.addTextCommand("set_chunking", [this](StreamClient* client, const QString& command) {
+		this->handleSetChunkingCommand(client, command);
+	});
+	this->commands.addTextCommand("set_batching", [this](StreamClient* client, const QString& command) {
+		this->handleSetBatchingCommand(client, command);
+	});
+	this->commands.addTextCommand("set_adaptive", [this](StreamClient* client, const QString& command) {
+		this->handleSetAdaptiveCommand(client, command);
+	});
+	this->commands.addTextCommand("get_stats", [this](StreamClient* client, const QString&) {
+		this->sendToClient(client, this->statsJson() + "\n");
+	}, CommandMatch::Exact);
+	this->commands.addTextCommand("set_stats_interval", [this](StreamClient* client, const QString& command) {
+		this->handleSetStatsIntervalCommand(client, command);
+	});
+	this->commands.addTextCommand("get_latency", [this](StreamClient* client, const QString&) {
+		this->sendToClient(client, this->latencyStats->report() + "\n");
+	}, CommandMatch::Exact);
+	this->commands.addTextCommand("reset_latency", [this](StreamClient* client, const QString&) {
+		this->latencyStats->reset();
+		this->sendToClient(client, "Latency statistics reset.\n");
+	}, CommandMatch::Exact);
+	this->commands.addTextCommand("clear_roi", [this](StreamClient* client, const QString&) {
+		StreamSubscription subscription = this->subscriptions.value(client);
+		subscription.region = RegionOfInterest();
+		this->updateSubscription(client, subscription);
+		this->sendToClient(client, "Region of interest cleared.\n");
+	}, CommandMatch::Exact);
+}
+
+void Broadcaster::rejectClientCommand(StreamClient* client, const QString& message) {
+	this->sendToClient(client, message + "\n");
+	emit error(this->tag + message);
+}
+
+void Broadcaster::updateSubscription(StreamClient* client, const StreamSubscription& subscription) {
+	// the client's own settings are kept here, the client applies them together with its adaptive quality level
+	this->subscriptions.insert(client, subscription);
+	StreamSubscription effective = QualityController::effectiveSubscription(subscription, this->sourceBitDepth);
+	QMetaObject::invokeMethod(client, "setSubscription", Q_ARG(StreamSubscription, effective));
+}
+
+void Broadcaster::handleSetDecimationCommand(StreamClient* client, const QString& command) {
+	// Format: set_decimation:every=<N>:fps=<F>, both keys optional. every=1:fps=0 sends every buffer again
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_decimation command format: " + errorMessage);
 		return;
 	}
 
-	if(dataString == "ping") {
-		if(auto webSocket = qobject_cast<QWebSocket*>(device)) {
-			webSocket->sendTextMessage("pong\n");
-		} else if(auto ioDevice = qobject_cast<QIODevice*>(device)) {
-			ioDevice->write("pong\n");
-		}
-	} else if(dataString == "enable_command_only_mode") {
-		if(dataConnections.contains(device)) {
-			dataConnections.removeAll(device);
-			commandConnections.append(device);
-			if(auto webSocket = qobject_cast<QWebSocket*>(device)) {
-				webSocket->sendTextMessage("Command mode enabled.\n");
-			} else if(auto ioDevice = qobject_cast<QIODevice*>(device)) {
-				ioDevice->write("Command mode enabled.\n");
+	StreamSubscription subscription = this->subscriptions.value(client);
+	for(auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		bool ok;
+		if(it.key() == "every") {
+			uint every = it.value().toString().toUInt(&ok);
+			if(!ok || every == 0) {
+				this->rejectClientCommand(client, "Invalid value for set_decimation every: " + it.value().toString());
+				return;
+			}
+			subscription.everyNthBuffer = every;
+		} else if(it.key() == "fps") {
+			double fps = it.value().toString().toDouble(&ok);
+			// NaN would pass a range check and mean no limit, tiny values overflow the frame interval
+			if(!ok || !qIsFinite(fps) || (fps != 0.0 && fps < MIN_FRAMES_PER_SECOND)) {
+				this->rejectClientCommand(client, QString("Invalid value for set_decimation fps, expected 0 or at least %1: ").arg(MIN_FRAMES_PER_SECOND) + it.value().toString());
+				return;
 			}
+			subscription.maxFramesPerSecond = fps;
+		} else {
+			this->rejectClientCommand(client, "Unknown set_decimation parameter: " + it.key());
+			return;
+		}
+	}
+
+	this->updateSubscription(client, subscription);
+	this->sendToClient(client, QString("Decimation set: every=%1 fps=%2\n").arg(subscription.everyNthBuffer).arg(subscription.maxFramesPerSecond));
+}
+
+void Broadcaster::handleSetRoiCommand(StreamClient* client, const QString& command) {
+	// Format: set_roi:samples=<begin>-<end>:lines=<begin>-<end>:frames=<begin>-<end>:sample_stride=<N>:line_stride=<N>:frame_stride=<N>
+	// all keys optional, ranges are half-open and an empty end ("100-") means up to the end of the buffer
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_roi command format: " + errorMessage);
+		return;
+	}
+
+	StreamSubscription subscription = this->subscriptions.value(client);
+	RegionOfInterest& region = subscription.region;
+	for(auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		QString value = it.value().toString();
+		bool ok = false;
+		if(it.key() == "samples") {
+			ok = parseRange(value, region.sampleBegin, region.sampleEnd);
+		} else if(it.key() == "lines") {
+			ok = parseRange(value, region.lineBegin, region.lineEnd);
+		} else if(it.key() == "frames") {
+			ok = parseRange(value, region.frameBegin, region.frameEnd);
+		} else if(it.key() == "sample_stride") {
+			region.sampleStride = value.toUInt(&ok);
+			ok = ok && region.sampleStride > 0;
+		} else if(it.key() == "line_stride") {
+			region.lineStride = value.toUInt(&ok);
+			ok = ok && region.lineStride > 0;
+		} else if(it.key() == "frame_stride") {
+			region.frameStride = value.toUInt(&ok);
+			ok = ok && region.frameStride > 0;
+		} else {
+			this->rejectClientCommand(client, "Unknown set_roi parameter: " + it.key());
+			return;
+		}
+		if(!ok) {
+			this->rejectClientCommand(client, "Invalid value for set_roi " + it.key() + ": " + value);
+			return;
+		}
+	}
+
+	this->updateSubscription(client, subscription);
+	this->sendToClient(client, QString("Region of interest set: samples=%1-%2/%3 lines=%4-%5/%6 frames=%7-%8/%9\n")
+		.arg(region.sampleBegin).arg(region.sampleEnd).arg(region.sampleStride)
+		.arg(region.lineBegin).arg(region.lineEnd).arg(region.lineStride)
+		.arg(region.frameBegin).arg(region.frameEnd).arg(region.frameStride));
+}
+
+void Broadcaster::handleSetBitDepthCommand(StreamClient* client, const QString& command) {
+	// Format: set_bit_depth:bits=<8|16>:min=<value>:max=<value>, bits=0 sends the native bit depth again
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_bit_depth command format: " + errorMessage);
+		return;
+	}
+	for(const QString& key : rawParams.keys()) {
+		if(key != "bits" && key != "min" && key != "max") {
+			this->rejectClientCommand(client, "Unknown set_bit_depth parameter: " + key);
+			return;
+		}
+	}
+
+	bool bitsOk;
+	uint bits = rawParams.value("bits").toString().toUInt(&bitsOk);
+	if(!bitsOk || (bits != 0 && bits != 8 && bits != 16)) {
+		this->rejectClientCommand(client, "Invalid value for set_bit_depth bits, expected 0, 8 or 16: " + rawParams.value("bits").toString());
+		return;
+	}
+
+	StreamSubscription subscription = this->subscriptions.value(client);
+	subscription.outputBitDepth = static_cast<quint8>(bits);
+	if(bits != 0) {
+		bool minOk, maxOk;
+		float windowMin = rawParams.value("min").toString().toFloat(&minOk);
+		float windowMax = rawParams.value("max").toString().toFloat(&maxOk);
+		if(!minOk || !maxOk || !(windowMax > windowMin)) {
+			this->rejectClientCommand(client, "Invalid set_bit_depth window, min and max are required and max must be greater than min.");
+			return;
+		}
+		subscription.windowMin = windowMin;
+		subscription.windowMax = windowMax;
+	}
+
+	this->updateSubscription(client, subscription);
+	if(bits == 0) {
+		this->sendToClient(client, "Bit depth reduction disabled.\n");
+	} else {
+		this->sendToClient(client, QString("Bit depth reduction set: bits=%1 min=%2 max=%3 (%4)\n").arg(bits).arg(subscription.windowMin).arg(subscription.windowMax).arg(BitDepthConverter::instructionSet()));
+	}
+}
+
+void Broadcaster::handleSetCompressionCommand(StreamClient* client, const QString& command) {
+	// Format: set_compression:codec=<none|zlib|shuffle_zlib>:level=<1-9>, level is optional
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_compression command format: " + errorMessage);
+		return;
+	}
+
+	StreamSubscription subscription = this->subscriptions.value(client);
+	for(auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		QString value = it.value().toString();
+		bool ok = false;
+		if(it.key() == "codec") {
+			ok = PayloadCompression::codecFromName(value, subscription.compression);
+		} else if(it.key() == "level") {
+			subscription.compressionLevel = value.toInt(&ok);
+			ok = ok && subscription.compressionLevel >= 1 && subscription.compressionLevel <= 9;
+		} else {
+			this->rejectClientCommand(client, "Unknown set_compression parameter: " + it.key());
+			return;
 		}
-	} else if(dataString == "disable_command_only_mode") {
-		if(commandConnections.contains(device)) {
-			commandConnections.removeAll(device);
-			dataConnections.append(device);
-			if(auto webSocket = qobject_cast<QWebSocket*>(device)) {
-				webSocket->sendTextMessage("Command mode disabled.\n");
-			} else if(auto ioDevice = qobject_cast<QIODevice*>(device)) {
-				ioDevice->write("Command mode disabled.\n");
+		if(!ok) {
+			this->rejectClientCommand(client, "Invalid value for set_compression " + it.key() + ": " + value);
+			return;
+		}
+	}
+	if(subscription.compression != PayloadCompression::None && !this->params.sendHeader) {
+		this->rejectClientCommand(client, "Compression requires the frame header, enable \"Include header to data transfer\" in the extension settings.");
+		return;
+	}
+
+	this->updateSubscription(client, subscription);
+	this->sendToClient(client, QString("Compression set: codec=%1 level=%2\n").arg(PayloadCompression::codecName(subscription.compression)).arg(subscription.compressionLevel));
+}
+
+void Broadcaster::handleSetStatsIntervalCommand(StreamClient* client, const QString& command) {
+	// Format: set_stats_interval:<seconds>, 0 stops the periodic push
+	bool ok = false;
+	int seconds = command.section(':', 1).trimmed().toInt(&ok);
+	if(!ok || seconds < 0) {
+		this->rejectClientCommand(client, "Invalid set_stats_interval command, expected set_stats_interval:<seconds>");
+		return;
+	}
+	StreamSubscription subscription = this->subscriptions.value(client);
+	subscription.statsIntervalSeconds = seconds;
+	this->updateSubscription(client, subscription);
+	this->sendToClient(client, QString("Stats interval set: %1 s\n").arg(seconds));
+}
+
+void Broadcaster::handleSetVolumeModeCommand(StreamClient* client, const QString& command) {
+	// Format: set_volume_mode:enable=<0|1>
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_volume_mode command format: " + errorMessage);
+		return;
+	}
+
+	StreamSubscription subscription = this->subscriptions.value(client);
+	for(auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		if(it.key() == "enable") {
+			if(!CommandParsing::parseBoolValue(it.value().toString(), subscription.volumeMode)) {
+				this->rejectClientCommand(client, "Invalid value for set_volume_mode enable: " + it.value().toString());
+				return;
 			}
+		} else {
+			this->rejectClientCommand(client, "Unknown set_volume_mode parameter: " + it.key());
+			return;
 		}
+	}
+
+	this->updateSubscription(client, subscription);
+	this->sendToClient(client, subscription.volumeMode ? "Volume mode enabled.\n" : "Volume mode disabled.\n");
+}
+
+void Broadcaster::handleSetPreviewCommand(StreamClient* client, const QString& command) {
+	// Format: set_preview:enable=<0|1>:format=<jpeg|png>:quality=<1-100>:width=<N>:height=<N>:fps=<F>:frame=<N>:min=<f>:max=<f>, all parameters are optional
+	if(!client->isWebSocket()) {
+		this->rejectClientCommand(client, "set_preview is only available for WebSocket clients.");
+		return;
+	}
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_preview command format: " + errorMessage);
+		return;
+	}
+
+	StreamSubscription subscription = this->subscriptions.value(client);
+	PreviewSettings& preview = subscription.preview;
+	for(auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		QString value = it.value().toString();
+		bool ok = false;
+		if(it.key() == "enable") {
+			ok = CommandParsing::parseBoolValue(value, preview.enabled);
+		} else if(it.key() == "format") {
+			ok = value == "jpeg" || value == "jpg" || value == "png";
+			preview.png = value == "png";
+		} else if(it.key() == "quality") {
+			preview.quality = value.toInt(&ok);
+			ok = ok && preview.quality >= 1 && preview.quality <= 100;
+		} else if(it.key() == "width") {
+			preview.maxWidth = value.toUInt(&ok);
+			ok = ok && preview.maxWidth > 0;
+		} else if(it.key() == "height") {
+			preview.maxHeight = value.toUInt(&ok);
+			ok = ok && preview.maxHeight > 0;
+		} else if(it.key() == "fps") {
+			preview.maxFramesPerSecond = value.toDouble(&ok);
+			ok = ok && qIsFinite(preview.maxFramesPerSecond) && preview.maxFramesPerSecond >= MIN_FRAMES_PER_SECOND;
+		} else if(it.key() == "frame") {
+			preview.frameIndex = value.toUInt(&ok);
+		} else if(it.key() == "min") {
+			preview.windowMin = value.toFloat(&ok);
+		} else if(it.key() == "max") {
+			preview.windowMax = value.toFloat(&ok);
+		} else {
+			this->rejectClientCommand(client, "Unknown set_preview parameter: " + it.key());
+			return;
+		}
+		if(!ok) {
+			this->rejectClientCommand(client, "Invalid value for set_preview " + it.key() + ": " + value);
+			return;
+		}
+	}
+	if(!(preview.windowMax > preview.windowMin) && !(preview.windowMin == 0.0f && preview.windowMax == 0.0f)) {
+		this->rejectClientCommand(client, "Invalid set_preview window, max must be greater than min (or both 0 for an automatic window).");
+		return;
+	}
+
+	this->updateSubscription(client, subscription);
+	if(!preview.enabled) {
+		this->sendToClient(client, "Preview disabled.\n");
 	} else {
-		emit remoteCommandReceived(dataString);
+		this->sendToClient(client, QString("Preview enabled: format=%1 quality=%2 width=%3 height=%4 fps=%5 frame=%6\n")
+			.arg(preview.png ? "png" : "jpeg").arg(preview.quality).arg(preview.maxWidth).arg(preview.maxHeight)
+			.arg(preview.maxFramesPerSecond).arg(preview.frameIndex));
 	}
 }
 
-void Broadcaster::broadcast(void* buffer, quint32 bufferSizeInBytes, quint16 framesPerBuffer, quint16 frameWidth, quint16 frameHeight, quint8 bitDepth) {
-	Q_UNUSED(framesPerBuffer);
-	QByteArray frameData;
-	QDataStream stream(&frameData, QIODevice::WriteOnly);
-	stream.setByteOrder(QDataStream::BigEndian);
+void Broadcaster::handleSetChunkingCommand(StreamClient* client, const QString& command) {
+	// Format: set_chunking:size=<bytes>, 0 sends every frame as one message again
+	if(!client->isWebSocket()) {
+		this->rejectClientCommand(client, "set_chunking is only available for WebSocket clients.");
+		return;
+	}
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_chunking command format: " + errorMessage);
+		return;
+	}
+
+	StreamSubscription subscription = this->subscriptions.value(client);
+	for(auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		QString value = it.value().toString();
+		if(it.key() == "size") {
+			bool ok = false;
+			quint32 size = value.toUInt(&ok);
+			if(!ok || (size != 0 && (size < WEBSOCKET_CHUNK_MIN_SIZE || size > WEBSOCKET_CHUNK_MAX_SIZE))) {
+				this->rejectClientCommand(client, QString("Invalid value for set_chunking size, expected 0 or %1 to %2 bytes: %3").arg(WEBSOCKET_CHUNK_MIN_SIZE).arg(WEBSOCKET_CHUNK_MAX_SIZE).arg(value));
+				return;
+			}
+			subscription.webSocketChunkSize = size;
+		} else {
+			this->rejectClientCommand(client, "Unknown set_chunking parameter: " + it.key());
+			return;
+		}
+	}
+
+	this->updateSubscription(client, subscription);
+	if(subscription.webSocketChunkSize == 0) {
+		this->sendToClient(client, "Chunking disabled.\n");
+	} else {
+		this->sendToClient(client, QString("Chunking set: size=%1\n").arg(subscription.webSocketChunkSize));
+	}
+}
+
+void Broadcaster::handleSetBatchingCommand(StreamClient* client, const QString& command) {
+	// Format: set_batching:enable=<0|1>
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_batching command format: " + errorMessage);
+		return;
+	}
+
+	StreamSubscription subscription = this->subscriptions.value(client);
+	for(auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		if(it.key() == "enable") {
+			if(!CommandParsing::parseBoolValue(it.value().toString(), subscription.batching)) {
+				this->rejectClientCommand(client, "Invalid value for set_batching enable: " + it.value().toString());
+				return;
+			}
+		} else {
+			this->rejectClientCommand(client, "Unknown set_batching parameter: " + it.key());
+			return;
+		}
+	}
 
-	// write header information to stream
-	if(this->params.sendHeader) {
-		stream << startIdentifier << bufferSizeInBytes << frameWidth << frameHeight << bitDepth;
-		if(this->params.sendTimestamp) {
-			// Send-side wall-clock ms since epoch. Consumed by measure_delay.py
-			// to compute the send->recv latency.
-			stream << static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+	this->updateSubscription(client, subscription);
+	if(!subscription.batching) {
+		this->sendToClient(client, "Batching disabled.\n");
+	} else {
+		this->sendToClient(client, QString("Batching enabled: frames=%1 kilobytes=%2 window_us=%3\n").arg(this->params.batchMaxFrames).arg(this->params.batchMaxKilobytes).arg(this->params.batchMaxMicroseconds));
+	}
+}
+
+void Broadcaster::handleSetAdaptiveCommand(StreamClient* client, const QString& command) {
+	// Format: set_adaptive:enable=<0|1>:min_bits=<0|8|16>:min=<v>:max=<v>:max_stride=<N>:max_decimation=<N>, all keys optional
+	QVariantMap rawParams;
+	QString errorMessage;
+	if(!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		this->rejectClientCommand(client, "Invalid set_adaptive command format: " + errorMessage);
+		return;
+	}
+
+	StreamSubscription subscription = this->subscriptions.value(client);
+	AdaptiveQualitySettings& adaptive = subscription.adaptive;
+	for(auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		QString value = it.value().toString();
+		bool ok = false;
+		if(it.key() == "enable") {
+			ok = CommandParsing::parseBoolValue(value, adaptive.enabled);
+		} else if(it.key() == "min_bits") {
+			int bits = value.toInt(&ok);
+			ok = ok && (bits == 0 || bits == 8 || bits == 16);
+			adaptive.minBitDepth = static_cast<quint8>(bits);
+		} else if(it.key() == "min") {
+			adaptive.windowMin = value.toFloat(&ok);
+		} else if(it.key() == "max") {
+			adaptive.windowMax = value.toFloat(&ok);
+		} else if(it.key() == "max_stride") {
+			adaptive.maxStride = value.toUInt(&ok);
+			ok = ok && adaptive.maxStride >= 1 && adaptive.maxStride <= 64;
+		} else if(it.key() == "max_decimation") {
+			adaptive.maxDecimation = value.toUInt(&ok);
+			ok = ok && adaptive.maxDecimation >= 1 && adaptive.maxDecimation <= 64;
+		} else {
+			this->rejectClientCommand(client, "Unknown set_adaptive parameter: " + it.key());
+			return;
+		}
+		if(!ok) {
+			this->rejectClientCommand(client, "Invalid value for set_adaptive " + it.key() + ": " + value);
+			return;
 		}
 	}
+	if(adaptive.minBitDepth != 0 && subscription.outputBitDepth == 0 && !(adaptive.windowMax > adaptive.windowMin)) {
+		this->rejectClientCommand(client, "Invalid set_adaptive window, min_bits requires min and max (max greater than min) unless set_bit_depth is active.");
+		return;
+	}
+
+	// every change of the limits starts again at full quality
+	adaptive.level = 0;
+	this->clientStats[client].quality.reset(client->droppedFrames());
+
+	this->updateSubscription(client, subscription);
+	if(!adaptive.enabled) {
+		this->sendToClient(client, "Adaptive quality disabled.\n");
+	} else {
+		this->sendToClient(client, QString("Adaptive quality enabled: min_bits=%1 max_stride=%2 max_decimation=%3 levels=%4\n")
+			.arg(adaptive.minBitDepth).arg(adaptive.maxStride).arg(adaptive.maxDecimation)
+			.arg(QualityController::steps(subscription, this->sourceBitDepth).size()));
+	}
+}
 
-	// append the actual OCT image data
-	frameData.append(static_cast<const char*>(buffer), bufferSizeInBytes);
+void Broadcaster::updateAdaptiveQuality(StreamClient* client, ClientStats& stats) {
+	StreamSubscription subscription = this->subscriptions.value(client);
+	int level = stats.quality.update(subscription, this->sourceBitDepth, stats.drainBytesPerSecond, client->droppedFrames(), client->queuedBytes());
+	if(level != subscription.adaptive.level) {
+		subscription.adaptive.level = static_cast<quint8>(level);
+		this->updateSubscription(client, subscription);
+	}
+}
+
+void Broadcaster::updateStats() {
+	// throughput is sampled once per second, get_stats reports the rate of the last full second
+	double elapsedSeconds = this->statsClock.restart() / 1000.0;
+	for(auto it = this->clientStats.begin(); it != this->clientStats.end(); ++it) {
+		quint64 bytesSent = it.key()->bytesSent();
+		if(elapsedSeconds > 0.0) {
+			it->throughputBytesPerSecond = (bytesSent - it->bytesSentAtLastSample) / elapsedSeconds;
+		}
+		it->bytesSentAtLastSample = bytesSent;
+		quint64 bytesDrained = it.key()->bytesDrained();
+		if(elapsedSeconds > 0.0) {
+			it->drainBytesPerSecond = (bytesDrained - it->bytesDrainedAtLastSample) / elapsedSeconds;
+		}
+		it->bytesDrainedAtLastSample = bytesDrained;
+		if(this->subscriptions.value(it.key()).adaptive.enabled) {
+			this->updateAdaptiveQuality(it.key(), it.value());
+		}
+	}
 
-	// send the data to dataConnections
-	for(QObject* connection : qAsConst(this->dataConnections)) {
-		if(auto ioDevice = qobject_cast<QIODevice*>(connection)) {
-			if(ioDevice->isOpen()) {
-				qint64 bytesWritten = ioDevice->write(frameData);
-				if(bytesWritten == -1) {
-					emit error(this->tag + tr("Failed to write to client: %1").arg(ioDevice->errorString()));
-				}
+	this->statsTick++;
+	QString stats;
+	for(auto it = this->subscriptions.cbegin(); it != this->subscriptions.cend(); ++it) {
+		int interval = it.value().statsIntervalSeconds;
+		if(interval > 0 && this->statsTick % static_cast<quint64>(interval) == 0) {
+			if(stats.isEmpty()) {
+				stats = this->statsJson() + "\n";
 			}
-		} else if(auto webSocket = qobject_cast<QWebSocket*>(connection)) {
-			if(webSocket->isValid()) {
-				webSocket->sendBinaryMessage(frameData);
+			this->sendToClient(it.key(), stats);
+		}
+	}
+}
+
+QString Broadcaster::statsJson() const {
+	QJsonArray clients;
+	for(auto it = this->clientStats.cbegin(); it != this->clientStats.cend(); ++it) {
+		StreamClient* client = it.key();
+		QJsonObject entry;
+		entry["id"] = static_cast<double>(it->id);
+		entry["transport"] = client->transportName();
+		entry["peer"] = client->peerName();
+		entry["receives_data"] = this->dataConnections.contains(client);
+		entry["connected_s"] = client->connectedMs() / 1000.0;
+		entry["bytes_sent"] = static_cast<double>(client->bytesSent());
+		entry["bytes_queued"] = static_cast<double>(client->queuedBytes());
+		entry["frames_sent"] = static_cast<double>(client->framesSent());
+		entry["frames_dropped"] = static_cast<double>(client->droppedFrames());
+		if(this->subscriptions.value(client).preview.enabled) {
+			entry["previews_skipped"] = static_cast<double>(client->skippedPreviews());
+		}
+		entry["write_errors"] = static_cast<double>(client->writeErrors());
+		entry["throughput_mb_s"] = it->throughputBytesPerSecond / 1.0e6;
+		entry["drain_mb_s"] = it->drainBytesPerSecond / 1.0e6;
+		const AdaptiveQualitySettings& adaptive = this->subscriptions.value(client).adaptive;
+		if(adaptive.enabled) {
+			entry["quality_level"] = adaptive.level;
+			entry["quality_levels"] = QualityController::steps(this->subscriptions.value(client), this->sourceBitDepth).size();
+			entry["capacity_mb_s"] = it->quality.capacityBytesPerSecond() / 1.0e6;
+		}
+		clients.append(entry);
+	}
+
+	QJsonObject latency;
+	for(int i = 0; i < LatencyStats::STAGE_COUNT; i++) {
+		LatencyStats::Stage stage = static_cast<LatencyStats::Stage>(i);
+		const LatencyHistogram& histogram = this->latencyStats->histogram(stage);
+		QJsonObject percentiles;
+		percentiles["p50"] = static_cast<double>(histogram.percentileUs(50.0));
+		percentiles["p99"] = static_cast<double>(histogram.percentileUs(99.0));
+		percentiles["max"] = static_cast<double>(histogram.maxUs());
+		latency[LatencyStats::stageName(stage)] = percentiles;
+	}
+
+	// frames_received counts every buffer OCTproZ delivered, frames_skipped those that found no free frame pool slot
+	QJsonObject stats;
+	stats["type"] = "stats";
+	stats["frames_received"] = static_cast<double>(this->framePool.isNull() ? this->framesBroadcast : this->framePool->acquireCount());
+	stats["frames_skipped"] = static_cast<double>(this->framePool.isNull() ? 0 : this->framePool->exhaustedCount());
+	stats["frames_broadcast"] = static_cast<double>(this->framesBroadcast);
+	stats["volumes_assembled"] = static_cast<double>(this->volumeAssembler.assembledCount());
+	stats["volumes_dropped"] = static_cast<double>(this->volumeAssembler.droppedCount());
+	stats["clients"] = clients;
+	if(this->multicastSender) {
+		QJsonObject multicast;
+		multicast["group"] = QString("%1:%2").arg(this->params.multicastGroup).arg(this->params.multicastPort);
+		multicast["frames_sent"] = static_cast<double>(this->multicastSender->framesSent());
+		multicast["datagrams_sent"] = static_cast<double>(this->multicastSender->datagramsSent());
+		multicast["frames_dropped"] = static_cast<double>(this->multicastSender->droppedFrames());
+		multicast["frames_incomplete"] = static_cast<double>(this->multicastSender->incompleteFrames());
+		stats["multicast"] = multicast;
+	}
+	stats["latency_us"] = latency;
+	return QString::fromUtf8(QJsonDocument(stats).toJson(QJsonDocument::Compact));
+}
+
+bool Broadcaster::parseRange(const QString& value, quint32& begin, quint32& end) {
+	int dashIndex = value.indexOf('-');
+	if(dashIndex <= 0) {
+		return false;
+	}
+	bool beginOk, endOk = true;
+	quint32 parsedBegin = value.left(dashIndex).toUInt(&beginOk);
+	QString endString = value.mid(dashIndex + 1);
+	quint32 parsedEnd = endString.isEmpty() ? 0 : endString.toUInt(&endOk);
+	if(!beginOk || !endOk || (parsedEnd != 0 && parsedEnd <= parsedBegin)) {
+		return false;
+	}
+	begin = parsedBegin;
+	end = parsedEnd;
+	return true;
+}
+
+void Broadcaster::broadcast(FrameRef frame) {
+	if(frame.isNull()) {
+		return;
+	}
+	qint64 dequeuedNs = LatencyStats::now();
+	this->latencyStats->record(LatencyStats::Invoke, frame->receivedNs, dequeuedNs);
+	this->framesBroadcast++;
+	this->sourceBitDepth = frame->bitDepth;
+	if(frame->sizeInBytes != this->frameSizeInBytes) {
+		this->frameSizeInBytes = frame->sizeInBytes;
+		this->updateFramePoolSize();
+	}
+
+	if(this->params.mode == CommunicationMode::SharedMemory) {
+		this->writeToSharedMemory(frame.data());
+	}
+
+	// volumes are assembled only while a client wants them, the volume slots are freed again afterwards
+	FrameRef volume;
+	if(this->hasVolumeClients()) {
+		volume = this->volumeAssembler.addBuffer(frame);
+	} else if(this->volumeAssembler.isActive()) {
+		this->volumeAssembler.reset();
+	}
+
+	// without buffers per volume the buffer already is the volume, it is serialized once for both kinds of clients
+	bool bufferIsVolume = volume.data() == frame.data();
+	this->serializeFrame(frame.data(), true, bufferIsVolume);
+	frame->serializedNs = LatencyStats::now();
+	this->latencyStats->record(LatencyStats::Serialize, dequeuedNs, frame->serializedNs);
+
+	// one copy of the frame for all multicast receivers, no matter how many have joined the group
+	if(this->multicastSender && this->multicastSender->reserveFrame()) {
+		QMetaObject::invokeMethod(this->multicastSender, "sendFrame", Q_ARG(FrameRef, frame));
+	}
+
+	this->enqueueFrame(frame, false);
+	if(!volume.isNull()) {
+		if(!bufferIsVolume) {
+			this->serializeFrame(volume.data(), false, true);
+			volume->serializedNs = LatencyStats::now();
+		}
+		this->enqueueFrame(volume, true);
+	}
+}
+
+void Broadcaster::serializeFrame(StreamFrame* frame, bool forBufferClients, bool forVolumeClients) {
+	frame->timestampMs = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+	int headerVersion = this->params.sendHeader ? qBound(1, this->params.headerVersion, 2) : 0;
+	if(StreamHeader::truncatesFields(frame, headerVersion) && !this->headerTruncationReported) {
+		emit error(this->tag + tr("Buffer size or geometry does not fit into the stream header and is truncated. Enable the extended header (v2)."));
+		this->headerTruncationReported = true;
+	}
+	StreamHeader::serialize(frame, headerVersion, this->params.sendHeader && this->params.sendTimestamp);
+
+	// WebSocket clients need header and payload in one message. It is assembled once per frame and shared by all WebSocket clients that receive the full buffer
+	for(StreamClient* client : qAsConst(this->dataConnections)) {
+		StreamSubscription subscription = this->subscriptions.value(client);
+		bool receivesFrame = subscription.volumeMode ? forVolumeClients : forBufferClients;
+		if(client->isWebSocket() && receivesFrame && subscription.usesSharedWebSocketMessage()) {
+			StreamHeader::buildWebSocketMessage(frame);
+			break;
+		}
+	}
+}
+
+void Broadcaster::enqueueFrame(const FrameRef& frame, bool forVolumeClients) {
+	// hand the frame to the send queue of each data connection. The frame is shared, it goes back to the frame pool once every client has sent it
+	for(StreamClient* client : qAsConst(this->dataConnections)) {
+		if(this->subscriptions.value(client).volumeMode == forVolumeClients) {
+			QMetaObject::invokeMethod(client, "enqueueFrame", Q_ARG(FrameRef, frame));
+		}
+	}
+}
+
+bool Broadcaster::hasVolumeClients() const {
+	for(StreamClient* client : this->dataConnections) {
+		if(this->subscriptions.value(client).volumeMode) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void Broadcaster::writeToSharedMemory(StreamFrame* frame) {
+	if(!this->isBroadcasting) {
+		return;
+	}
+
+	// (re)create the ring if there is none yet or the buffer size has grown. Attached readers see the old ring closing and reopen it by name
+	if(!this->sharedMemoryRing.isOpen() || frame->sizeInBytes > this->sharedMemoryRing.getSlotSize()) {
+		if(!this->sharedMemoryRing.create(this->sharedMemoryName(), this->params.sharedMemorySlots, frame->sizeInBytes)) {
+			if(!this->sharedMemoryErrorReported) {
+				emit error(this->tag + this->sharedMemoryRing.getErrorString());
+				this->sharedMemoryErrorReported = true;
 			}
+			return;
 		}
+		emit info(this->tag + tr("Shared memory ring %1 created with %2 slots of %3 bytes.").arg(this->sharedMemoryRing.getName()).arg(this->sharedMemoryRing.getSlotCount()).arg(this->sharedMemoryRing.getSlotSize()));
+	}
+	this->sharedMemoryRing.write(frame);
+}
+
+QString Broadcaster::sharedMemoryName() const {
+	return "octproz_" + QString(this->params.pipeName).remove('/');
+}
+
+void Broadcaster::openMulticastSender() {
+	// the sender gets a thread of its own: it waits up to 100 ms for every datagram that does not fit into the full send buffer, which must neither hold up the broadcaster thread nor the clients of a sender thread
+	this->closeMulticastSender();
+	this->multicastSender = new UdpMulticastSender();
+	this->multicastThread = new QThread(this);
+	this->multicastThread->setObjectName("SocketStreamMulticast");
+	this->multicastSender->moveToThread(this->multicastThread);
+	connect(this->multicastThread, &QThread::finished, this->multicastSender, &QObject::deleteLater);
+	this->multicastThread->start();
+	connect(this->multicastSender, &UdpMulticastSender::error, this, [this](const QString message) {
+		emit error(this->tag + message);
+	});
+	connect(this->multicastSender, &UdpMulticastSender::info, this, [this](const QString message) {
+		emit info(this->tag + message);
+	});
+	QMetaObject::invokeMethod(this->multicastSender, "open", Q_ARG(QString, this->params.multicastGroup), Q_ARG(quint16, this->params.multicastPort),
+		Q_ARG(int, this->params.multicastTtl), Q_ARG(int, this->params.multicastDatagramSize), Q_ARG(QString, this->params.ip),
+		Q_ARG(int, this->params.socketOptions.sendBufferKilobytes * 1024));
+	this->updateFramePoolSize();
+}
+
+void Broadcaster::closeMulticastSender() {
+	if(this->multicastSender) {
+		// the sender closes its socket when it is deleted at the end of its thread, frames still queued for it go back to the frame pool
+		this->multicastThread->quit();
+		this->multicastThread->wait();
+		delete this->multicastThread;
+		this->multicastThread = nullptr;
+		this->multicastSender = nullptr;
+		this->updateFramePoolSize();
 	}
 }
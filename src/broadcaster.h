@@ -41,9 +41,37 @@
 #include <QWebSocketServer>
 #include <QWebSocket>
 #include <QList>
+#include <QVector>
+#include <QHash>
+#include <QThread>
 #include <QByteArray>
 #include <QString>
+#include <QTimer>
+#include <QElapsedTimer>
 #include "socketstreamextensionparameters.h"
+#include "streamclient.h"
+#include "streamsubscription.h"
+#include "latencystats.h"
+#include "framepool.h"
+#include "sharedmemoryring.h"
+#include "udpmulticastsender.h"
+#include "volumeassembler.h"
+#include "commanddispatcher.h"
+#include "qualitycontroller.h"
+#include "socketoptions.h"
+
+#define FRAME_POOL_PIPELINE_SLOTS 2   // the buffer being copied in the acquisition callback and the one waiting for the broadcaster thread
+#define FRAME_POOL_CLIENT_IN_FLIGHT 2 // per client besides its send queue: the frame its socket is writing and one on its way to the sender thread
+
+// Broadcaster side bookkeeping for the get_stats command
+struct ClientStats {
+	quint64 id = 0;
+	quint64 bytesSentAtLastSample = 0;
+	double throughputBytesPerSecond = 0.0;
+	quint64 bytesDrainedAtLastSample = 0;
+	double drainBytesPerSecond = 0.0;
+	QualityController quality;
+};
 
 class Broadcaster : public QObject {
 	Q_OBJECT
@@ -52,47 +80,99 @@ public:
 	explicit Broadcaster(QObject* parent = nullptr);
 	~Broadcaster();
 
+	void setFramePool(QSharedPointer<FramePool> pool) { this->framePool = pool; } // before the broadcaster is moved to its thread, sized by updateFramePoolSize()
+
 signals:
 	void listeningEnabled(bool enabled);
 	void error(const QString message);
 	void info(const QString message);
 	void remoteCommandReceived(const QString& command);
+	void remoteBinaryCommandReceived(quint16 opcode, const QByteArray& payload);
 
 public slots:
 	void setParams(const SocketStreamExtensionParameters params);
 	void startBroadcasting();
 	void stopBroadcasting();
-	void broadcast(void* buffer, quint32 bufferSizeInBytes, quint16 framesPerBuffer, quint16 frameWidth, quint16 frameHeight, quint8 bitDepth);
+	void broadcast(FrameRef frame);
 
 private slots:
 	void onClientConnected();
 	void onWebSocketConnected();
-	void onWebSocketDisconnected();
 	void onClientDisconnected();
-	void readyRead();
-	void onTextMessageReceived(const QString& message);
-	void onBinaryMessageReceived(const QByteArray& message);
-	void processIncomingMessage(const QString& dataString, QObject* device);
+	void onClientMessageReceived(const QString& message);
+	void onClientBinaryCommandReceived(quint16 opcode, const QByteArray& payload);
+	void processIncomingMessage(const QString& dataString, StreamClient* client);
+	void updateStats();
 
 private:
-	void configure(const SocketStreamExtensionParameters params);
+	void registerCommands();
+	bool updateListeners();
+	template<typename Server> void closeServer(Server*& server, const QString& transport);
+	void addClient(StreamClient* client, bool receivesData);
+	void removeClient(StreamClient* client);
+	void applyQueueLimits(StreamClient* client);
+	void updateFramePoolSize();
+	void reportSocketOptionFailures(const QStringList& failed, const QString& transport);
+	void sendToClient(StreamClient* client, const QString& text);
+	void rejectClientCommand(StreamClient* client, const QString& message);
+	void updateSubscription(StreamClient* client, const StreamSubscription& subscription);
+	void handleSetDecimationCommand(StreamClient* client, const QString& command);
+	void handleSetRoiCommand(StreamClient* client, const QString& command);
+	void handleSetBitDepthCommand(StreamClient* client, const QString& command);
+	void handleSetCompressionCommand(StreamClient* client, const QString& command);
+	void handleSetStatsIntervalCommand(StreamClient* client, const QString& command);
+	void handleSetVolumeModeCommand(StreamClient* client, const QString& command);
+	void handleSetPreviewCommand(StreamClient* client, const QString& command);
+	void handleSetChunkingCommand(StreamClient* client, const QString& command);
+	void handleSetBatchingCommand(StreamClient* client, const QString& command);
+	void handleSetAdaptiveCommand(StreamClient* client, const QString& command);
+	void updateAdaptiveQuality(StreamClient* client, ClientStats& stats);
+	void serializeFrame(StreamFrame* frame, bool forBufferClients, bool forVolumeClients);
+	void enqueueFrame(const FrameRef& frame, bool forVolumeClients);
+	bool hasVolumeClients() const;
+	QString statsJson() const;
+	static bool parseRange(const QString& value, quint32& begin, quint32& end);
+	void setupSenderThreads(int count);
+	void stopSenderThreads();
+	QThread* leastLoadedSenderThread() const;
+	void writeToSharedMemory(StreamFrame* frame);
+	QString sharedMemoryName() const;
+	void openMulticastSender();
+	void closeMulticastSender();
 
 	QTcpServer* tcpServer;
 	QLocalServer* localServer;
 	QWebSocketServer* webSocketServer;
 
-	QList<QTcpSocket*> tcpConnections;
-	QList<QLocalSocket*> localConnections;
-	QList<QWebSocket*> webSocketConnections;
+	QList<StreamClient*> dataConnections;
+	QList<StreamClient*> commandConnections;
+	CommandDispatcher<StreamClient*> commands; // client commands handled here, all others are forwarded to the extension
+
+	QVector<QThread*> senderThreads;
+	QHash<StreamClient*, QThread*> clientThreads;
+	QHash<StreamClient*, StreamSubscription> subscriptions;
+	QSharedPointer<LatencyStats> latencyStats;
+	QHash<StreamClient*, ClientStats> clientStats;
+	quint64 nextClientId;
+	QSharedPointer<FramePool> framePool;
+	quint64 framesBroadcast;
+	quint8 sourceBitDepth; // of the last buffer, 0 = none yet. The adaptive quality steps depend on it
+	quint64 frameSizeInBytes; // of the last buffer, 0 = none yet. The frame pool is sized with it
+	VolumeAssembler volumeAssembler;
+	QTimer* statsTimer;
+	QElapsedTimer statsClock;
+	quint64 statsTick;
 
-	QList<QObject*> dataConnections;
-	QList<QObject*> commandConnections;
+	SharedMemoryRing sharedMemoryRing;
+	bool sharedMemoryErrorReported;
+	bool headerTruncationReported;
+	bool socketOptionsErrorReported; // once per change of the options, otherwise every new connection would report it
+	UdpMulticastSender* multicastSender;
+	QThread* multicastThread;
 
 	SocketStreamExtensionParameters params;
 	QString tag;
 	bool isBroadcasting;
-
-	static quint32 startIdentifier;
 };
 
 #endif // BROADCASTER_H
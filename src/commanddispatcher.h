@@ -0,0 +1,104 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef COMMANDDISPATCHER_H
+#define COMMANDDISPATCHER_H
+
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include <functional>
+#include "commandparsing.h"
+#include "binarycommand.h"
+
+// How much of a text command has to match the registered name.
+enum class CommandMatch {
+	Name,              // the leading name, whatever follows is up to the handler
+	Exact,             // the whole command, for commands without parameters
+	ExactOrParameters  // the whole command, or the name followed by ':' and parameters
+};
+
+// Lookup table for remote commands. Text commands are found by their name
+// (see CommandParsing::commandName), binary commands by their opcode.
+// Context is passed through to the handlers, e.g. the client that sent the command.
+template<typename... Context>
+class CommandDispatcher {
+public:
+	typedef std::function<void(Context..., const QString&)> TextHandler;
+	typedef std::function<void(Context..., BinaryCommandReader&)> BinaryHandler;
+
+	void addTextCommand(const QString& name, TextHandler handler, CommandMatch match = CommandMatch::Name) {
+		this->textHandlers.insert(name.toLower(), TextEntry{handler, match});
+	}
+
+	void addBinaryCommand(quint16 opcode, BinaryHandler handler) {
+		this->binaryHandlers.insert(opcode, handler);
+	}
+
+	// false if there is no handler for the command
+	bool dispatchText(Context... context, const QString& command) const {
+		QString name = CommandParsing::commandName(command);
+		auto entry = this->textHandlers.constFind(name);
+		if(entry == this->textHandlers.cend()) {
+			return false;
+		}
+		// commands without parameters are unknown if anything follows their name, e.g. "stream_raw:0" must not switch to raw streaming
+		bool exact = command.size() == name.size();
+		bool withParameters = command.size() > name.size() && command.at(name.size()) == ':';
+		if((entry->match == CommandMatch::Exact && !exact) || (entry->match == CommandMatch::ExactOrParameters && !exact && !withParameters)) {
+			return false;
+		}
+		entry->handler(context..., command);
+		return true;
+	}
+
+	bool dispatchBinary(Context... context, quint16 opcode, const QByteArray& payload) const {
+		auto handler = this->binaryHandlers.constFind(opcode);
+		if(handler == this->binaryHandlers.cend()) {
+			return false;
+		}
+		BinaryCommandReader reader(payload);
+		(*handler)(context..., reader);
+		return true;
+	}
+
+private:
+	struct TextEntry {
+		TextHandler handler;
+		CommandMatch match;
+	};
+
+	QHash<QString, TextEntry> textHandlers;
+	QHash<quint16, BinaryHandler> binaryHandlers;
+};
+
+#endif // COMMANDDISPATCHER_H
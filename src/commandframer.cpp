@@ -0,0 +1,146 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "commandframer.h"
+#include <QtEndian>
+#include <cstring>
+
+CommandFramer::CommandFramer(int maxCommandSize) : readPosition(0), writePosition(0), scanPosition(0), maxCommandSize(maxCommandSize), overflow(false) {
+}
+
+char* CommandFramer::prepareAppend(qint64 size) {
+	this->compact();
+	int required = this->writePosition + static_cast<int>(size);
+	if(required > this->buffer.size()) {
+		this->buffer.resize(qMax(required, this->buffer.size() * 2));
+	}
+	return this->buffer.data() + this->writePosition;
+}
+
+void CommandFramer::commitAppend(qint64 size) {
+	this->writePosition += static_cast<int>(size);
+}
+
+void CommandFramer::append(const QByteArray& data) {
+	memcpy(this->prepareAppend(data.size()), data.constData(), static_cast<size_t>(data.size()));
+	this->commitAppend(data.size());
+}
+
+bool CommandFramer::next(FramedCommand& command) {
+	if(this->hasPending() && this->buffer.at(this->readPosition) == BINARY_COMMAND_MARKER) {
+		return this->nextBinary(command);
+	}
+	const char* start = this->buffer.constData();
+	const char* newline = static_cast<const char*>(memchr(start + this->scanPosition, '\n', static_cast<size_t>(this->writePosition - this->scanPosition)));
+	if(!newline) {
+		this->scanPosition = this->writePosition;
+		if(this->writePosition - this->readPosition > this->maxCommandSize) {
+			// a client that never terminates its command must not make the buffer grow without limit
+			this->discard();
+			this->overflow = true;
+		}
+		return false;
+	}
+	int end = static_cast<int>(newline - start);
+	int length = end - this->readPosition;
+	if(length > 0 && start[end - 1] == '\r') {
+		length--;
+	}
+	command.isBinary = false;
+	command.opcode = 0;
+	command.data = QByteArray(start + this->readPosition, length);
+	this->readPosition = end + 1;
+	this->scanPosition = this->readPosition;
+	if(this->readPosition == this->writePosition) {
+		this->discard();
+	}
+	return true;
+}
+
+bool CommandFramer::nextBinary(FramedCommand& command) {
+	if(this->writePosition - this->readPosition < BINARY_COMMAND_HEADER_SIZE) {
+		return false;
+	}
+	const char* header = this->buffer.constData() + this->readPosition;
+	quint32 payloadSize = qFromLittleEndian<quint32>(header + 3);
+	if(payloadSize > static_cast<quint32>(this->maxCommandSize)) {
+		// the stream cannot be resynchronized after a corrupt length, everything buffered is dropped
+		this->discard();
+		this->overflow = true;
+		return false;
+	}
+	int frameSize = BINARY_COMMAND_HEADER_SIZE + static_cast<int>(payloadSize);
+	if(this->writePosition - this->readPosition < frameSize) {
+		return false;
+	}
+	command.isBinary = true;
+	command.opcode = qFromLittleEndian<quint16>(header + 1);
+	command.data = QByteArray(header + BINARY_COMMAND_HEADER_SIZE, static_cast<int>(payloadSize));
+	this->readPosition += frameSize;
+	this->scanPosition = this->readPosition;
+	if(this->readPosition == this->writePosition) {
+		this->discard();
+	}
+	return true;
+}
+
+QByteArray CommandFramer::takePending() {
+	if(!this->hasPending() || this->buffer.at(this->readPosition) == BINARY_COMMAND_MARKER) {
+		return QByteArray();
+	}
+	QByteArray pending(this->buffer.constData() + this->readPosition, this->writePosition - this->readPosition);
+	this->discard();
+	return pending;
+}
+
+void CommandFramer::discard() {
+	this->readPosition = 0;
+	this->writePosition = 0;
+	this->scanPosition = 0;
+}
+
+bool CommandFramer::overflowed() {
+	bool result = this->overflow;
+	this->overflow = false;
+	return result;
+}
+
+void CommandFramer::compact() {
+	// moves the unread rest to the front, the buffer itself keeps its size
+	if(this->readPosition > 0) {
+		int remaining = this->writePosition - this->readPosition;
+		memmove(this->buffer.data(), this->buffer.constData() + this->readPosition, static_cast<size_t>(remaining));
+		this->scanPosition -= this->readPosition;
+		this->writePosition = remaining;
+		this->readPosition = 0;
+	}
+}
@@ -0,0 +1,80 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef COMMANDFRAMER_H
+#define COMMANDFRAMER_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include "binarycommand.h"
+
+#define COMMAND_FRAMER_MAX_SIZE (16 * 1024 * 1024) // large enough for k-linearization curves with many values
+
+struct FramedCommand {
+	bool isBinary = false;
+	quint16 opcode = 0;
+	QByteArray data; // text command without line ending, or the payload of a binary command
+};
+
+// Incremental splitter for newline terminated commands ("\n" or "\r\n") and
+// length-prefixed binary commands (see binarycommand.h).
+// Data is appended as it arrives, next() returns one complete command at a
+// time, so several pipelined commands in one read and commands split over
+// several reads are both handled. The buffer is reused between reads.
+class CommandFramer {
+public:
+	explicit CommandFramer(int maxCommandSize = COMMAND_FRAMER_MAX_SIZE);
+
+	// reserve room for size bytes at the end of the buffer, then commit what was actually written there
+	char* prepareAppend(qint64 size);
+	void commitAppend(qint64 size);
+	void append(const QByteArray& data);
+
+	bool next(FramedCommand& command); // false if no complete command is buffered
+	bool hasPending() const { return this->writePosition > this->readPosition; }
+	QByteArray takePending();          // the unterminated rest, for clients that do not send a newline. Empty for an incomplete binary command
+	bool overflowed();                // true once after a command exceeded the maximum size and was discarded
+
+private:
+	bool nextBinary(FramedCommand& command);
+	void discard();
+	void compact();
+
+	QByteArray buffer;
+	int readPosition;
+	int writePosition;
+	int scanPosition; // everything before this position has already been searched for a newline
+	int maxCommandSize;
+	bool overflow;
+};
+
+#endif // COMMANDFRAMER_H
@@ -0,0 +1,127 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "commandparsing.h"
+#include <QStringList>
+
+QString CommandParsing::commandName(const QString &command) {
+	int length = 0;
+	while (length < command.size()) {
+		QChar c = command.at(length);
+		if (!c.isLetterOrNumber() && c != '_') {
+			break;
+		}
+		length++;
+	}
+	return command.left(length).toLower();
+}
+
+bool CommandParsing::parseCoefficients(const QString &command, double coeffs[4], bool present[4]) {
+	QStringList parts = command.toLower().split(":", QString::SkipEmptyParts);
+	if (parts.size() != 5) {
+		return false;
+	}
+	for (int i = 0; i < 4; i++) {
+		const QString& part = parts.at(i + 1);
+		coeffs[i] = part.toDouble(&present[i]);
+		if (!present[i] && part != "nullptr" && part != "null") {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool CommandParsing::parseFloatList(const QString &values, QVector<float> &parsedValues, QString &invalidValue) {
+	const QVector<QStringRef> parts = values.splitRef(",", QString::SkipEmptyParts);
+	parsedValues.clear();
+	parsedValues.reserve(parts.size());
+	for (const QStringRef& part : parts) {
+		bool ok;
+		float value = part.trimmed().toFloat(&ok);
+		if (!ok) {
+			invalidValue = part.trimmed().toString();
+			return false;
+		}
+		parsedValues.append(value);
+	}
+	return true;
+}
+
+bool CommandParsing::parseBoolValue(const QString &value, bool &parsedValue) {
+	QString normalized = value.trimmed().toLower();
+	if (normalized == "1" || normalized == "true") {
+		parsedValue = true;
+		return true;
+	}
+	if (normalized == "0" || normalized == "false") {
+		parsedValue = false;
+		return true;
+	}
+	return false;
+}
+
+bool CommandParsing::parseKeyValueCommand(const QString &command, QVariantMap &rawParams, QString &errorMessage) {
+	int colonIndex = command.indexOf(':');
+	if (colonIndex < 0 || colonIndex == command.size() - 1) {
+		errorMessage = "missing parameters";
+		return false;
+	}
+
+	QStringList parts = command.mid(colonIndex + 1).split(":", QString::SkipEmptyParts);
+	if (parts.isEmpty()) {
+		errorMessage = "missing parameters";
+		return false;
+	}
+
+	for (const QString& part : parts) {
+		int equalsIndex = part.indexOf('=');
+		if (equalsIndex <= 0 || equalsIndex == part.size() - 1) {
+			errorMessage = "invalid key=value pair: " + part.trimmed();
+			return false;
+		}
+
+		QString key = part.left(equalsIndex).trimmed().toLower();
+		QString value = part.mid(equalsIndex + 1).trimmed();
+		if (key.isEmpty() || value.isEmpty()) {
+			errorMessage = "invalid key=value pair: " + part.trimmed();
+			return false;
+		}
+		if (rawParams.contains(key)) {
+			errorMessage = "duplicate key: " + key;
+			return false;
+		}
+
+		rawParams.insert(key, value);
+	}
+
+	return true;
+}
@@ -0,0 +1,50 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef COMMANDPARSING_H
+#define COMMANDPARSING_H
+
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+// Helpers for the text command format shared by the extension and the
+// broadcaster: "<command>:<key>=<value>:<key>=<value>..."
+namespace CommandParsing {
+	QString commandName(const QString &command); // leading letters, digits and underscores, lower case
+	bool parseCoefficients(const QString &command, double coeffs[4], bool present[4]); // "<command>:<c0>:<c1>:<c2>:<c3>", "null" leaves a coefficient unset
+	bool parseFloatList(const QString &values, QVector<float> &parsedValues, QString &invalidValue); // comma separated
+	bool parseBoolValue(const QString &value, bool &parsedValue);
+	bool parseKeyValueCommand(const QString &command, QVariantMap &rawParams, QString &errorMessage);
+}
+
+#endif // COMMANDPARSING_H
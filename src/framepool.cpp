@@ -0,0 +1,182 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "framepool.h"
+#include <QMutexLocker>
+#include <QWeakPointer>
+#include <cstring>
+
+#define FRAME_POOL_ALIGNMENT 64
+
+FramePool::FramePool(int slotCount) : slotCount(qMax(1, slotCount)), slotsInUse(0), slotSizeInBytes(0), exhausted(0), acquired(0) {
+}
+
+FramePool::~FramePool() {
+	QMutexLocker locker(&this->mutex);
+	for(StreamFrame* frame : qAsConst(this->freeSlots)) {
+		freeFrame(frame);
+	}
+	this->freeSlots.clear();
+}
+
+FrameRef FramePool::acquire(quint64 sizeInBytes) {
+	StreamFrame* frame = nullptr;
+	{
+		QMutexLocker locker(&this->mutex);
+		this->acquired++;
+		if(sizeInBytes != this->slotSizeInBytes) {
+			this->resize(sizeInBytes);
+		}
+		if(!this->freeSlots.isEmpty()) {
+			frame = this->freeSlots.takeLast();
+		} else if(this->slotsInUse < this->slotCount) {
+			// only happens after a resize while slots of the old size were still in use, or while setSlotCount is still allocating
+			frame = allocateFrame(this->slotSizeInBytes);
+		}
+		if(frame && !frame->data) {
+			freeFrame(frame); // allocation failed, buffer does not fit into memory
+			frame = nullptr;
+		}
+		if(!frame) {
+			this->exhausted++;
+			return FrameRef();
+		}
+		this->slotsInUse++;
+	}
+
+	frame->sizeInBytes = sizeInBytes;
+	frame->headerSize = 0;
+	frame->headerVersion = 0;
+	frame->sequenceNumber = 0;
+	frame->isRaw = false;
+	frame->compressedCodec = PayloadCompression::None;
+	frame->receivedNs = 0;
+	frame->serializedNs = 0;
+	QWeakPointer<FramePool> weakPool = this->sharedFromThis();
+	return FrameRef(frame, [weakPool](StreamFrame* releasedFrame) {
+		QSharedPointer<FramePool> pool = weakPool.toStrongRef();
+		if(pool) {
+			pool->release(releasedFrame);
+		} else {
+			freeFrame(releasedFrame);
+		}
+	});
+}
+
+void FramePool::setSlotCount(int slotCount) {
+	// slots are allocated and freed without holding the mutex, so acquire() in the acquisition callback does not wait for the allocation of large buffers
+	QVector<StreamFrame*> surplus;
+	int missing = 0;
+	quint64 slotSize = 0;
+	{
+		QMutexLocker locker(&this->mutex);
+		this->slotCount = qMax(1, slotCount);
+		while(!this->freeSlots.isEmpty() && this->freeSlots.size() + this->slotsInUse > this->slotCount) {
+			surplus.append(this->freeSlots.takeLast());
+		}
+		slotSize = this->slotSizeInBytes;
+		missing = slotSize > 0 ? this->slotCount - this->freeSlots.size() - this->slotsInUse : 0;
+	}
+	for(StreamFrame* frame : qAsConst(surplus)) {
+		freeFrame(frame);
+	}
+	if(missing <= 0) {
+		return;
+	}
+
+	QVector<StreamFrame*> allocated;
+	allocated.reserve(missing);
+	for(int i = 0; i < missing; i++) {
+		allocated.append(allocateFrame(slotSize));
+	}
+	{
+		// the slot size or count may have changed in the meantime, slots that are no longer needed are freed below
+		QMutexLocker locker(&this->mutex);
+		while(!allocated.isEmpty() && allocated.last()->capacity == this->slotSizeInBytes && this->freeSlots.size() + this->slotsInUse < this->slotCount) {
+			this->freeSlots.append(allocated.takeLast());
+		}
+	}
+	for(StreamFrame* frame : qAsConst(allocated)) {
+		freeFrame(frame);
+	}
+}
+
+quint64 FramePool::exhaustedCount() const {
+	QMutexLocker locker(&this->mutex);
+	return this->exhausted;
+}
+
+quint64 FramePool::acquireCount() const {
+	QMutexLocker locker(&this->mutex);
+	return this->acquired;
+}
+
+void FramePool::release(StreamFrame* frame) {
+	QMutexLocker locker(&this->mutex);
+	this->slotsInUse--;
+	if(frame->capacity != this->slotSizeInBytes || this->freeSlots.size() + this->slotsInUse >= this->slotCount) {
+		freeFrame(frame); // slot of an old geometry or pool was shrunk
+		return;
+	}
+	this->freeSlots.append(frame);
+}
+
+void FramePool::resize(quint64 slotSizeInBytes) {
+	// called with mutex locked
+	for(StreamFrame* frame : qAsConst(this->freeSlots)) {
+		freeFrame(frame);
+	}
+	this->freeSlots.clear();
+	this->slotSizeInBytes = slotSizeInBytes;
+	for(int i = this->slotsInUse; i < this->slotCount; i++) {
+		this->freeSlots.append(allocateFrame(slotSizeInBytes));
+	}
+}
+
+StreamFrame* FramePool::allocateFrame(quint64 sizeInBytes) {
+	StreamFrame* frame = new StreamFrame();
+	frame->data = static_cast<char*>(qMallocAligned(static_cast<size_t>(sizeInBytes), FRAME_POOL_ALIGNMENT));
+	frame->capacity = frame->data ? sizeInBytes : 0;
+	frame->sizeInBytes = 0;
+	frame->headerSize = 0;
+	frame->headerVersion = 0;
+	frame->sequenceNumber = 0;
+	frame->isRaw = false;
+	frame->compressedCodec = PayloadCompression::None;
+	frame->compressionLevel = 0;
+	return frame;
+}
+
+void FramePool::freeFrame(StreamFrame* frame) {
+	qFreeAligned(frame->data);
+	delete frame;
+}
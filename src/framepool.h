@@ -0,0 +1,104 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QtGlobal>
+#include <QMetaType>
+#include <QSharedPointer>
+#include <QEnableSharedFromThis>
+#include <QMutex>
+#include <QVector>
+#include <QByteArray>
+#include "payloadcompression.h"
+
+#define STREAM_HEADER_CAPACITY 80
+
+// Owned copy of one buffer delivered by OCTproZ. The memory comes from a
+// FramePool slot and goes back to the pool when the last FrameRef is released.
+struct StreamFrame {
+	char* data;
+	quint64 capacity;
+	quint64 sizeInBytes;
+	quint8 bitDepth;
+	quint32 samplesPerLine;
+	quint32 linesPerFrame;
+	quint32 framesPerBuffer;
+	quint32 buffersPerVolume;
+	quint32 currentBufferNr;
+	quint64 sequenceNumber; // counts every buffer delivered by OCTproZ, also the ones that were skipped
+	bool isRaw; // raw acquisition data instead of processed data
+	quint64 timestampMs; // wall-clock time the frame was broadcast, ms since epoch
+	qint64 receivedNs; // LatencyStats::now() at the acquisition callback
+	qint64 serializedNs; // LatencyStats::now() after the broadcaster has serialized the frame
+	char header[STREAM_HEADER_CAPACITY]; // serialized stream header, reused with the slot
+	int headerSize;
+	int headerVersion; // 0 = no header
+	QByteArray webSocketMessage; // header and payload in one message for WebSocket clients, capacity is reused with the slot
+	QMutex compressionMutex; // compression tasks of different clients share the compressed payload
+	QByteArray compressedPayload; // null if the payload did not get smaller
+	PayloadCompression::Codec compressedCodec; // codec of compressedPayload, None if nothing was compressed yet
+	int compressionLevel;
+};
+typedef QSharedPointer<StreamFrame> FrameRef;
+Q_DECLARE_METATYPE(FrameRef)
+
+// Preallocated, geometry-sized frame slots. acquire() never allocates as long
+// as the buffer size stays the same; slots are only reallocated when the
+// size changes. acquire() and release are thread safe.
+class FramePool : public QEnableSharedFromThis<FramePool> {
+public:
+	explicit FramePool(int slotCount);
+	~FramePool();
+
+	FrameRef acquire(quint64 sizeInBytes);
+	void setSlotCount(int slotCount);
+	quint64 exhaustedCount() const;
+	quint64 acquireCount() const;
+
+private:
+	void release(StreamFrame* frame);
+	void resize(quint64 slotSizeInBytes);
+	static StreamFrame* allocateFrame(quint64 sizeInBytes);
+	static void freeFrame(StreamFrame* frame);
+
+	mutable QMutex mutex;
+	QVector<StreamFrame*> freeSlots;
+	int slotCount;
+	int slotsInUse;
+	quint64 slotSizeInBytes;
+	quint64 exhausted;
+	quint64 acquired;
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,110 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "frameregion.h"
+#include <cstring>
+
+namespace {
+	quint32 stridedCount(quint32 begin, quint32 end, quint32 dimension, quint32 stride) {
+		quint32 last = (end == 0 || end > dimension) ? dimension : end;
+		if(begin >= last || stride == 0) {
+			return 0;
+		}
+		return (last - begin + stride - 1) / stride;
+	}
+
+	template <typename T>
+	void copyStrided(const char* source, char* target, quint32 count, quint32 stride) {
+		const T* in = reinterpret_cast<const T*>(source);
+		T* out = reinterpret_cast<T*>(target);
+		for(quint32 i = 0; i < count; i++) {
+			out[i] = in[static_cast<size_t>(i) * stride];
+		}
+	}
+}
+
+quint64 FrameRegion::bytesPerSample(quint8 bitDepth) {
+	return (static_cast<quint64>(bitDepth) + 7) / 8;
+}
+
+bool FrameRegion::outputGeometry(const StreamFrame* source, const RegionOfInterest& region, quint32& samples, quint32& lines, quint32& frames) {
+	samples = stridedCount(region.sampleBegin, region.sampleEnd, source->samplesPerLine, region.sampleStride);
+	lines = stridedCount(region.lineBegin, region.lineEnd, source->linesPerFrame, region.lineStride);
+	frames = stridedCount(region.frameBegin, region.frameEnd, source->framesPerBuffer, region.frameStride);
+	return samples > 0 && lines > 0 && frames > 0;
+}
+
+void FrameRegion::extract(const StreamFrame* source, const RegionOfInterest& region, StreamFrame* target) {
+	quint32 samples, lines, frames;
+	if(!outputGeometry(source, region, samples, lines, frames)) {
+		target->sizeInBytes = 0;
+		return;
+	}
+	quint64 sampleSize = bytesPerSample(source->bitDepth);
+	quint64 lineSize = source->samplesPerLine * sampleSize;
+	quint64 frameSize = source->linesPerFrame * lineSize;
+	quint64 outputLineSize = samples * sampleSize;
+
+	// one A-scan (line) at a time: samples of a line are contiguous in memory, so without a sample stride every line is a single memcpy
+	char* out = target->data;
+	for(quint32 f = 0; f < frames; f++) {
+		const char* frameStart = source->data + (region.frameBegin + static_cast<quint64>(f) * region.frameStride) * frameSize;
+		for(quint32 l = 0; l < lines; l++) {
+			const char* in = frameStart + (region.lineBegin + static_cast<quint64>(l) * region.lineStride) * lineSize + region.sampleBegin * sampleSize;
+			if(region.sampleStride == 1) {
+				memcpy(out, in, static_cast<size_t>(outputLineSize));
+			} else if(sampleSize == 1) {
+				copyStrided<quint8>(in, out, samples, region.sampleStride);
+			} else if(sampleSize == 2) {
+				copyStrided<quint16>(in, out, samples, region.sampleStride);
+			} else if(sampleSize == 4) {
+				copyStrided<quint32>(in, out, samples, region.sampleStride);
+			} else {
+				for(quint32 s = 0; s < samples; s++) {
+					memcpy(out + s * sampleSize, in + static_cast<quint64>(s) * region.sampleStride * sampleSize, static_cast<size_t>(sampleSize));
+				}
+			}
+			out += outputLineSize;
+		}
+	}
+
+	target->sizeInBytes = static_cast<quint64>(out - target->data);
+	target->bitDepth = source->bitDepth;
+	target->samplesPerLine = samples;
+	target->linesPerFrame = lines;
+	target->framesPerBuffer = frames;
+	target->buffersPerVolume = source->buffersPerVolume;
+	target->currentBufferNr = source->currentBufferNr;
+	target->sequenceNumber = source->sequenceNumber;
+	target->isRaw = source->isRaw;
+	target->timestampMs = source->timestampMs;
+}
@@ -0,0 +1,49 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef FRAMEREGION_H
+#define FRAMEREGION_H
+
+#include "framepool.h"
+#include "streamsubscription.h"
+
+// Extraction of a RegionOfInterest from a buffer of
+// framesPerBuffer x linesPerFrame x samplesPerLine samples.
+namespace FrameRegion {
+	// geometry of the extracted region, false if the region is empty for this buffer
+	bool outputGeometry(const StreamFrame* source, const RegionOfInterest& region, quint32& samples, quint32& lines, quint32& frames);
+	// copies the region into target, which must be large enough. Geometry fields of target are set
+	void extract(const StreamFrame* source, const RegionOfInterest& region, StreamFrame* target);
+	quint64 bytesPerSample(quint8 bitDepth);
+}
+
+#endif // FRAMEREGION_H
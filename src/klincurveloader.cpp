@@ -0,0 +1,213 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "klincurveloader.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <cstring>
+
+namespace {
+	const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+	inline bool isBlank(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	double scaleByPowerOfTen(double value, int exponent) {
+		//powers up to 1e22 are exact in a double, larger exponents are applied in steps
+		while(exponent > 22) {
+			value *= 1e22;
+			exponent -= 22;
+		}
+		while(exponent < -22) {
+			value /= 1e22;
+			exponent += 22;
+		}
+		return exponent >= 0 ? value * powersOfTen[exponent] : value / powersOfTen[-exponent];
+	}
+}
+
+KLinCurveLoader::KLinCurveLoader(QObject* parent) : QObject(parent), cache(KLIN_CURVE_CACHE_ENTRIES) {
+}
+
+void KLinCurveLoader::load(const QString& fileName, quint64 requestId) {
+	QElapsedTimer timer;
+	timer.start();
+
+	QFileInfo info(fileName);
+	if(!info.exists() || !info.isFile()) {
+		emit loadFailed(fileName, requestId, "Could not open k-linearization curve file: " + fileName);
+		return;
+	}
+	QString key = info.absoluteFilePath();
+	CachedCurve* cached = this->cache.object(key);
+	if(cached && cached->size == info.size() && cached->lastModified == info.lastModified()) {
+		emit curveLoaded(fileName, requestId, cached->curve, true, timer.nsecsElapsed() / 1000);
+		return;
+	}
+
+	QFile file(fileName);
+	if(!file.open(QIODevice::ReadOnly)) {
+		emit loadFailed(fileName, requestId, "Could not open k-linearization curve file: " + fileName);
+		return;
+	}
+	QVector<float> curve;
+	qint64 size = file.size();
+	uchar* mapped = size > 0 ? file.map(0, size) : nullptr;
+	if(mapped) {
+		parseCurve(reinterpret_cast<const char*>(mapped), size, curve);
+		file.unmap(mapped);
+	} else {
+		//some file systems cannot be mapped
+		QByteArray content = file.readAll();
+		parseCurve(content.constData(), content.size(), curve);
+	}
+	file.close();
+
+	if(curve.isEmpty()) {
+		emit loadFailed(fileName, requestId, "K-linearization curve file is empty or has wrong format: " + fileName);
+		return;
+	}
+
+	CachedCurve* entry = new CachedCurve();
+	entry->size = info.size();
+	entry->lastModified = info.lastModified();
+	entry->curve = curve;
+	this->cache.insert(key, entry);
+	emit curveLoaded(fileName, requestId, curve, false, timer.nsecsElapsed() / 1000);
+}
+
+bool KLinCurveLoader::parseCurve(const char* data, qint64 size, QVector<float>& curve) {
+	//same rules as the former QTextStream reader: skip the header line, take the second column, skip lines without a valid number there
+	curve.clear();
+	const char* end = data + size;
+	const char* line = static_cast<const char*>(memchr(data, '\n', static_cast<size_t>(size)));
+	line = line ? line + 1 : end;
+	curve.reserve(static_cast<int>(qMin<qint64>((end - line) / 4 + 1, 1 << 24)));
+	while(line < end) {
+		const char* lineEnd = static_cast<const char*>(memchr(line, '\n', static_cast<size_t>(end - line)));
+		if(!lineEnd) {
+			lineEnd = end;
+		}
+		const char* field = static_cast<const char*>(memchr(line, ';', static_cast<size_t>(lineEnd - line)));
+		if(field) {
+			field++;
+			const char* fieldEnd = static_cast<const char*>(memchr(field, ';', static_cast<size_t>(lineEnd - field)));
+			if(!fieldEnd) {
+				fieldEnd = lineEnd;
+			}
+			float value;
+			const char* position = field;
+			while(position < fieldEnd && isBlank(*position)) {
+				position++;
+			}
+			if(parseFloat(position, fieldEnd, value)) {
+				while(position < fieldEnd && isBlank(*position)) {
+					position++;
+				}
+				if(position == fieldEnd) {
+					curve.append(value);
+				}
+			}
+		}
+		line = lineEnd + 1;
+	}
+	return !curve.isEmpty();
+}
+
+bool KLinCurveLoader::parseFloat(const char*& position, const char* end, float& value) {
+	const char* p = position;
+	bool negative = false;
+	if(p < end && (*p == '-' || *p == '+')) {
+		negative = *p == '-';
+		p++;
+	}
+	quint64 mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	bool anyDigit = false;
+	while(p < end && *p >= '0' && *p <= '9') {
+		if(digits < 19) {
+			mantissa = mantissa * 10 + static_cast<quint64>(*p - '0');
+			if(mantissa > 0) {
+				digits++;
+			}
+		} else {
+			exponent++;
+		}
+		anyDigit = true;
+		p++;
+	}
+	if(p < end && *p == '.') {
+		p++;
+		while(p < end && *p >= '0' && *p <= '9') {
+			if(digits < 19) {
+				mantissa = mantissa * 10 + static_cast<quint64>(*p - '0');
+				if(mantissa > 0) {
+					digits++;
+				}
+				exponent--;
+			}
+			anyDigit = true;
+			p++;
+		}
+	}
+	if(!anyDigit) {
+		return false;
+	}
+	if(p < end && (*p == 'e' || *p == 'E')) {
+		const char* exponentStart = p;
+		p++;
+		bool negativeExponent = false;
+		if(p < end && (*p == '-' || *p == '+')) {
+			negativeExponent = *p == '-';
+			p++;
+		}
+		if(p < end && *p >= '0' && *p <= '9') {
+			int explicitExponent = 0;
+			while(p < end && *p >= '0' && *p <= '9') {
+				if(explicitExponent < 10000) {
+					explicitExponent = explicitExponent * 10 + (*p - '0');
+				}
+				p++;
+			}
+			exponent += negativeExponent ? -explicitExponent : explicitExponent;
+		} else {
+			p = exponentStart; //"1e" is the number 1 followed by text
+		}
+	}
+	double result = mantissa == 0 ? 0.0 : scaleByPowerOfTen(static_cast<double>(mantissa), exponent);
+	value = static_cast<float>(negative ? -result : result);
+	position = p;
+	return true;
+}
@@ -0,0 +1,74 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef KLINCURVELOADER_H
+#define KLINCURVELOADER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QDateTime>
+#include <QCache>
+
+#define KLIN_CURVE_CACHE_ENTRIES 16
+
+// Loads k-linearization curve files (CSV, semicolon separated, value in the second
+// column, first line is a header) in the thread it has been moved to. The file is
+// memory-mapped and parsed without QString or locale lookups. Parsed curves are cached
+// by path, size and modification time, so switching back to an unchanged file only
+// costs a stat.
+class KLinCurveLoader : public QObject {
+	Q_OBJECT
+
+public:
+	explicit KLinCurveLoader(QObject* parent = nullptr);
+
+	static bool parseCurve(const char* data, qint64 size, QVector<float>& curve);
+	static bool parseFloat(const char*& position, const char* end, float& value); // locale independent, advances position behind the number
+
+public slots:
+	void load(const QString& fileName, quint64 requestId);
+
+signals:
+	void curveLoaded(const QString& fileName, quint64 requestId, const QVector<float>& curve, bool fromCache, qint64 elapsedUs);
+	void loadFailed(const QString& fileName, quint64 requestId, const QString& message);
+
+private:
+	struct CachedCurve {
+		qint64 size;
+		QDateTime lastModified;
+		QVector<float> curve;
+	};
+	QCache<QString, CachedCurve> cache;
+};
+
+#endif // KLINCURVELOADER_H
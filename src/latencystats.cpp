@@ -0,0 +1,163 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "latencystats.h"
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QtAlgorithms>
+
+LatencyHistogram::LatencyHistogram() : total(0), maximum(0) {
+	for(int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		this->buckets[i].store(0);
+	}
+}
+
+void LatencyHistogram::record(qint64 durationNs) {
+	quint64 us = durationNs > 0 ? static_cast<quint64>(durationNs) / 1000 : 0;
+	this->buckets[bucketIndex(us)].fetchAndAddRelaxed(1);
+	this->total.fetchAndAddRelaxed(1);
+	quint64 currentMax = this->maximum.load();
+	while(us > currentMax && !this->maximum.testAndSetRelaxed(currentMax, us, currentMax)) {
+	}
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+	for(int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		this->buckets[i].fetchAndAddRelaxed(other.buckets[i].load());
+	}
+	this->total.fetchAndAddRelaxed(other.total.load());
+	quint64 otherMax = other.maximum.load();
+	quint64 currentMax = this->maximum.load();
+	while(otherMax > currentMax && !this->maximum.testAndSetRelaxed(currentMax, otherMax, currentMax)) {
+	}
+}
+
+quint64 LatencyHistogram::count() const {
+	return this->total.load();
+}
+
+quint64 LatencyHistogram::percentileUs(double percentile) const {
+	// the counters may change while this runs, the result is still a valid estimate
+	quint64 sampleCount = this->total.load();
+	if(sampleCount == 0) {
+		return 0;
+	}
+	quint64 rank = static_cast<quint64>(percentile / 100.0 * static_cast<double>(sampleCount) + 0.5);
+	rank = qBound(static_cast<quint64>(1), rank, sampleCount);
+	quint64 cumulative = 0;
+	for(int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		cumulative += this->buckets[i].load();
+		if(cumulative >= rank) {
+			return qMin(bucketUpperBound(i), this->maximum.load());
+		}
+	}
+	return this->maximum.load();
+}
+
+quint64 LatencyHistogram::maxUs() const {
+	return this->maximum.load();
+}
+
+void LatencyHistogram::reset() {
+	for(int i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+		this->buckets[i].store(0);
+	}
+	this->total.store(0);
+	this->maximum.store(0);
+}
+
+int LatencyHistogram::bucketIndex(quint64 us) {
+	if(us < LATENCY_HISTOGRAM_EXACT_BUCKETS) {
+		return static_cast<int>(us);
+	}
+	int exponent = 63 - static_cast<int>(qCountLeadingZeroBits(us)); // >= 5
+	int subBucket = static_cast<int>((us >> (exponent - 3)) & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1));
+	return LATENCY_HISTOGRAM_EXACT_BUCKETS + (exponent - 5) * LATENCY_HISTOGRAM_SUB_BUCKETS + subBucket;
+}
+
+quint64 LatencyHistogram::bucketUpperBound(int index) {
+	if(index < LATENCY_HISTOGRAM_EXACT_BUCKETS) {
+		return static_cast<quint64>(index);
+	}
+	int exponent = 5 + (index - LATENCY_HISTOGRAM_EXACT_BUCKETS) / LATENCY_HISTOGRAM_SUB_BUCKETS;
+	quint64 subBucket = static_cast<quint64>((index - LATENCY_HISTOGRAM_EXACT_BUCKETS) % LATENCY_HISTOGRAM_SUB_BUCKETS);
+	return ((LATENCY_HISTOGRAM_SUB_BUCKETS + subBucket + 1) << (exponent - 3)) - 1;
+}
+
+qint64 LatencyStats::now() {
+	// QElapsedTimer uses the monotonic clock of the system, one shared reference makes timestamps of different threads comparable
+	static const QElapsedTimer clock = []() {
+		QElapsedTimer timer;
+		timer.start();
+		return timer;
+	}();
+	return clock.nsecsElapsed();
+}
+
+QString LatencyStats::stageName(Stage stage) {
+	switch(stage) {
+	case Invoke: return "invoke";
+	case Serialize: return "serialize";
+	case Send: return "send";
+	case Total: return "total";
+	default: return "unknown";
+	}
+}
+
+void LatencyStats::record(Stage stage, qint64 startNs, qint64 endNs) {
+	if(startNs <= 0) {
+		return; // frame was not timestamped at this stage
+	}
+	this->histograms[stage].record(endNs - startNs);
+}
+
+QString LatencyStats::report() const {
+	QStringList lines;
+	for(int i = 0; i < STAGE_COUNT; i++) {
+		const LatencyHistogram& histogram = this->histograms[i];
+		lines << QString("latency_us stage=%1 count=%2 p50=%3 p90=%4 p99=%5 p99.9=%6 max=%7")
+			.arg(stageName(static_cast<Stage>(i)))
+			.arg(histogram.count())
+			.arg(histogram.percentileUs(50.0))
+			.arg(histogram.percentileUs(90.0))
+			.arg(histogram.percentileUs(99.0))
+			.arg(histogram.percentileUs(99.9))
+			.arg(histogram.maxUs());
+	}
+	return lines.join("\n");
+}
+
+void LatencyStats::reset() {
+	for(int i = 0; i < STAGE_COUNT; i++) {
+		this->histograms[i].reset();
+	}
+}
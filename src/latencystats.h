@@ -0,0 +1,91 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef LATENCYSTATS_H
+#define LATENCYSTATS_H
+
+#include <QtGlobal>
+#include <QAtomicInteger>
+#include <QString>
+
+#define LATENCY_HISTOGRAM_EXACT_BUCKETS 32
+#define LATENCY_HISTOGRAM_SUB_BUCKETS 8
+#define LATENCY_HISTOGRAM_BUCKETS (LATENCY_HISTOGRAM_EXACT_BUCKETS + (64 - 5) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+// Histogram of durations in microseconds with logarithmic buckets: exact below
+// 32 us, above that 8 buckets per power of two (at most 12.5% error). record()
+// is lock free and may be called from any thread.
+class LatencyHistogram {
+public:
+	LatencyHistogram();
+
+	void record(qint64 durationNs);
+	void merge(const LatencyHistogram& other);
+	quint64 count() const;
+	quint64 percentileUs(double percentile) const;
+	quint64 maxUs() const;
+	void reset();
+
+private:
+	static int bucketIndex(quint64 us);
+	static quint64 bucketUpperBound(int index);
+
+	QAtomicInteger<quint64> buckets[LATENCY_HISTOGRAM_BUCKETS];
+	QAtomicInteger<quint64> total;
+	QAtomicInteger<quint64> maximum;
+};
+
+// Per-stage latencies of the stream pipeline. Timestamps are taken with
+// now(), a monotonic clock with nanosecond resolution shared by all threads.
+class LatencyStats {
+public:
+	enum Stage {
+		Invoke,     // acquisition callback to broadcast() in the broadcaster thread
+		Serialize,  // broadcast() to header serialized and frame handed to the clients
+		Send,       // serialized to fully written to the socket of a client
+		Total,      // acquisition callback to fully written to the socket of a client
+		STAGE_COUNT
+	};
+
+	static qint64 now();
+	static QString stageName(Stage stage);
+
+	void record(Stage stage, qint64 startNs, qint64 endNs);
+	const LatencyHistogram& histogram(Stage stage) const { return this->histograms[stage]; }
+	QString report() const;
+	void reset();
+
+private:
+	LatencyHistogram histograms[STAGE_COUNT];
+};
+
+#endif // LATENCYSTATS_H
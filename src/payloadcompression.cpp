@@ -0,0 +1,107 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "payloadcompression.h"
+#include <QThread>
+#include <cstring>
+#include <limits>
+
+namespace {
+	struct CompressionPool : public QThreadPool {
+		CompressionPool() {
+			this->setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 4));
+		}
+	};
+	Q_GLOBAL_STATIC(CompressionPool, compressionPool)
+
+	void shuffleBytes(const char* data, quint64 sizeInBytes, quint64 bytesPerSample, char* output) {
+		quint64 sampleCount = sizeInBytes / bytesPerSample;
+		for(quint64 byte = 0; byte < bytesPerSample; byte++) {
+			const char* in = data + byte;
+			char* out = output + byte * sampleCount;
+			for(quint64 i = 0; i < sampleCount; i++) {
+				out[i] = in[i * bytesPerSample];
+			}
+		}
+		// bytes of an incomplete last sample are appended unchanged
+		quint64 tail = sampleCount * bytesPerSample;
+		memcpy(output + tail, data + tail, static_cast<size_t>(sizeInBytes - tail));
+	}
+}
+
+bool PayloadCompression::codecFromName(const QString& name, Codec& codec) {
+	QString normalized = name.trimmed().toLower();
+	if(normalized == "none") {
+		codec = None;
+	} else if(normalized == "zlib") {
+		codec = Zlib;
+	} else if(normalized == "shuffle_zlib") {
+		codec = ShuffleZlib;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+QString PayloadCompression::codecName(Codec codec) {
+	switch(codec) {
+	case Zlib: return "zlib";
+	case ShuffleZlib: return "shuffle_zlib";
+	default: return "none";
+	}
+}
+
+QByteArray PayloadCompression::compress(const char* data, quint64 sizeInBytes, quint64 bytesPerSample, Codec codec, int level, QByteArray& shuffleBuffer) {
+	if(codec == None || sizeInBytes == 0 || sizeInBytes > static_cast<quint64>(std::numeric_limits<int>::max())) {
+		return QByteArray();
+	}
+	int size = static_cast<int>(sizeInBytes);
+
+	const char* input = data;
+	if(codec == ShuffleZlib && bytesPerSample > 1) {
+		shuffleBuffer.resize(size);
+		shuffleBytes(data, sizeInBytes, bytesPerSample, shuffleBuffer.data());
+		input = shuffleBuffer.constData();
+	}
+
+	QByteArray compressed = qCompress(reinterpret_cast<const uchar*>(input), size, level);
+	// qCompress prepends the uncompressed size as 4 byte big-endian integer, the stream header already carries it
+	if(compressed.size() <= 4 || compressed.size() - 4 >= size) {
+		return QByteArray();
+	}
+	compressed.remove(0, 4);
+	return compressed;
+}
+
+QThreadPool* PayloadCompression::threadPool() {
+	return compressionPool();
+}
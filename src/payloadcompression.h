@@ -0,0 +1,59 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef PAYLOADCOMPRESSION_H
+#define PAYLOADCOMPRESSION_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+#include <QThreadPool>
+
+// Lossless payload compression for clients that opt in with set_compression.
+// The codecs use the zlib that is built into Qt, so no additional library is
+// needed. ShuffleZlib groups byte n of every sample together before
+// compressing, which makes multi-byte samples compress much better.
+namespace PayloadCompression {
+	enum Codec : quint8 {
+		None = 0,
+		Zlib = 1,
+		ShuffleZlib = 2
+	};
+
+	bool codecFromName(const QString& name, Codec& codec);
+	QString codecName(Codec codec);
+	// raw zlib stream of the payload, null if compression does not make it smaller. shuffleBuffer is reused between calls
+	QByteArray compress(const char* data, quint64 sizeInBytes, quint64 bytesPerSample, Codec codec, int level, QByteArray& shuffleBuffer);
+	QThreadPool* threadPool(); // shared by all clients, keeps zlib off the sender threads and the broadcaster thread
+}
+
+#endif // PAYLOADCOMPRESSION_H
@@ -0,0 +1,119 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "previewencoder.h"
+#include <QImage>
+#include <QBuffer>
+#include <QVector>
+#include <QThread>
+#include <limits>
+
+namespace {
+	struct EncoderPool : public QThreadPool {
+		EncoderPool() {
+			this->setMaxThreadCount(qMax(1, QThread::idealThreadCount() / 4));
+		}
+	};
+	Q_GLOBAL_STATIC(EncoderPool, encoderPool)
+
+	float sampleAt(const char* data, quint8 bitDepth, quint64 index) {
+		if(bitDepth <= 8) {
+			return reinterpret_cast<const quint8*>(data)[index];
+		}
+		if(bitDepth <= 16) {
+			return reinterpret_cast<const quint16*>(data)[index];
+		}
+		return reinterpret_cast<const float*>(data)[index];
+	}
+}
+
+QByteArray PreviewEncoder::encode(const StreamFrame* frame, const PreviewSettings& settings) {
+	quint32 samples = frame->samplesPerLine;
+	quint32 lines = frame->linesPerFrame;
+	quint32 frames = qMax(frame->framesPerBuffer, 1u);
+	quint32 bytesPerSample = frame->bitDepth <= 8 ? 1 : frame->bitDepth <= 16 ? 2 : 4;
+	quint64 frameSamples = static_cast<quint64>(samples) * lines;
+	if(frameSamples == 0 || frame->sizeInBytes < frameSamples * frames * bytesPerSample) {
+		return QByteArray();
+	}
+	quint32 frameIndex = qMin(settings.frameIndex, frames - 1);
+	const char* data = frame->data + frameIndex * frameSamples * bytesPerSample;
+
+	//nearest neighbour downsampling, a B-scan has far more samples than a browser preview needs
+	int width = static_cast<int>(qMin(samples, qMax(settings.maxWidth, 1u)));
+	int height = static_cast<int>(qMin(lines, qMax(settings.maxHeight, 1u)));
+	QVector<float> values(width * height);
+	float minValue = std::numeric_limits<float>::max();
+	float maxValue = std::numeric_limits<float>::lowest();
+	for(int y = 0; y < height; y++) {
+		quint64 line = static_cast<quint64>(y) * lines / height;
+		for(int x = 0; x < width; x++) {
+			quint64 sample = static_cast<quint64>(x) * samples / width;
+			float value = sampleAt(data, frame->bitDepth, line * samples + sample);
+			values[y * width + x] = value;
+			if(value == value) { //NaN does not take part in the automatic window
+				minValue = qMin(minValue, value);
+				maxValue = qMax(maxValue, value);
+			}
+		}
+	}
+
+	float windowMin = settings.windowMin;
+	float windowMax = settings.windowMax;
+	if(windowMin == 0.0f && windowMax == 0.0f) {
+		windowMin = minValue;
+		windowMax = maxValue;
+	}
+	float scale = windowMax > windowMin ? 255.0f / (windowMax - windowMin) : 0.0f;
+
+	QImage image(width, height, QImage::Format_Grayscale8);
+	for(int y = 0; y < height; y++) {
+		uchar* row = image.scanLine(y);
+		const float* source = values.constData() + y * width;
+		for(int x = 0; x < width; x++) {
+			float mapped = (source[x] - windowMin) * scale;
+			row[x] = mapped > 0.0f ? (mapped < 255.0f ? static_cast<uchar>(mapped + 0.5f) : 255) : 0;
+		}
+	}
+
+	QByteArray encoded;
+	QBuffer buffer(&encoded);
+	buffer.open(QIODevice::WriteOnly);
+	if(!image.save(&buffer, settings.png ? "PNG" : "JPG", settings.png ? -1 : qBound(1, settings.quality, 100))) {
+		return QByteArray();
+	}
+	return encoded;
+}
+
+QThreadPool* PreviewEncoder::threadPool() {
+	return encoderPool();
+}
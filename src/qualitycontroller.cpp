@@ -0,0 +1,158 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "qualitycontroller.h"
+
+QualityController::QualityController() : droppedAtLastUpdate(0), capacity(0.0), stableSeconds(0), holdSeconds(QUALITY_CONTROLLER_HOLD_SECONDS), secondsSinceChange(0), lastChangeWasStepUp(false) {
+}
+
+void QualityController::reset(quint64 droppedFrames) {
+	*this = QualityController();
+	this->droppedAtLastUpdate = droppedFrames;
+}
+
+QVector<QualityController::Step> QualityController::steps(const StreamSubscription& subscription, quint8 sourceBitDepth) {
+	const AdaptiveQualitySettings& limits = subscription.adaptive;
+	QVector<Step> result;
+
+	// bit depth steps only exist if they actually reduce the data the client receives
+	if(limits.minBitDepth > 0) {
+		quint8 bitDepth = sourceBitDepth == 0 ? 32 : sourceBitDepth;
+		if(subscription.outputBitDepth != 0 && subscription.outputBitDepth < bitDepth) {
+			bitDepth = subscription.outputBitDepth;
+		}
+		if(bitDepth > 16 && limits.minBitDepth <= 16) {
+			result.append(BitDepth16);
+		}
+		if(bitDepth > 8 && limits.minBitDepth <= 8) {
+			result.append(BitDepth8);
+		}
+	}
+	for(quint32 stride = 2; stride <= limits.maxStride; stride *= 2) {
+		result.append(Stride);
+	}
+	for(quint32 decimation = 2; decimation <= limits.maxDecimation; decimation *= 2) {
+		result.append(Decimation);
+	}
+	return result;
+}
+
+StreamSubscription QualityController::effectiveSubscription(const StreamSubscription& subscription, quint8 sourceBitDepth) {
+	if(!subscription.adaptive.enabled || subscription.adaptive.level == 0) {
+		return subscription;
+	}
+	StreamSubscription effective = subscription;
+	QVector<Step> levelSteps = steps(subscription, sourceBitDepth);
+	int level = qMin(static_cast<int>(subscription.adaptive.level), levelSteps.size());
+	for(int i = 0; i < level; i++) {
+		switch(levelSteps.at(i)) {
+			case BitDepth16:
+			case BitDepth8:
+				// a window set with set_bit_depth is kept, otherwise the one of set_adaptive is used
+				if(subscription.outputBitDepth == 0) {
+					effective.windowMin = subscription.adaptive.windowMin;
+					effective.windowMax = subscription.adaptive.windowMax;
+				}
+				effective.outputBitDepth = levelSteps.at(i) == BitDepth16 ? 16 : 8;
+				break;
+			case Stride:
+				effective.region.sampleStride *= 2;
+				effective.region.lineStride *= 2;
+				break;
+			case Decimation:
+				effective.everyNthBuffer *= 2;
+				break;
+		}
+	}
+	effective.adaptive.level = static_cast<quint8>(level);
+	return effective;
+}
+
+int QualityController::update(const StreamSubscription& subscription, quint8 sourceBitDepth, double drainBytesPerSecond, quint64 droppedFrames, qint64 queuedBytes) {
+	QVector<Step> levelSteps = steps(subscription, sourceBitDepth);
+	int level = qMin(static_cast<int>(subscription.adaptive.level), levelSteps.size());
+	quint64 newDrops = droppedFrames - this->droppedAtLastUpdate;
+	this->droppedAtLastUpdate = droppedFrames;
+	this->secondsSinceChange++;
+
+	// the link is congested if frames were dropped or more than a second of data waits in the queue. The drain rate is then what the link can carry
+	bool congested = newDrops > 0 || (drainBytesPerSecond > 0.0 && queuedBytes > drainBytesPerSecond);
+	if(congested) {
+		this->stableSeconds = 0;
+		if(drainBytesPerSecond > 0.0) {
+			this->capacity = drainBytesPerSecond;
+		}
+		// the queue needs a moment to drain after a step down, so a second step waits for the next interval
+		if(level >= levelSteps.size() || (this->secondsSinceChange < 2 && !this->lastChangeWasStepUp)) {
+			return level;
+		}
+		if(this->lastChangeWasStepUp && this->secondsSinceChange <= this->holdSeconds) {
+			this->holdSeconds = qMin(this->holdSeconds * 2, QUALITY_CONTROLLER_MAX_HOLD_SECONDS);
+		}
+		this->secondsSinceChange = 0;
+		this->lastChangeWasStepUp = false;
+		return level + 1;
+	}
+
+	this->stableSeconds++;
+	if(drainBytesPerSecond > this->capacity) {
+		this->capacity = 0.0; // the link carries more than at the last congestion, the estimate is outdated
+	}
+	if(level == 0 || this->stableSeconds < this->holdSeconds) {
+		return level;
+	}
+	// uncongested, the drain rate is what the client currently needs. A step up is taken if the estimated rate fits, and after a long quiet time in any case to probe for more capacity
+	double rateAfterStepUp = drainBytesPerSecond / rateFactor(levelSteps.at(level - 1));
+	bool fits = this->capacity <= 0.0 || rateAfterStepUp < QUALITY_CONTROLLER_HEADROOM * this->capacity;
+	if(!fits && this->stableSeconds < 4 * this->holdSeconds) {
+		return level;
+	}
+	if(this->lastChangeWasStepUp) {
+		this->holdSeconds = qMax(this->holdSeconds / 2, QUALITY_CONTROLLER_HOLD_SECONDS); // the previous step up held, the link seems stable again
+	}
+	this->stableSeconds = 0;
+	this->secondsSinceChange = 0;
+	this->lastChangeWasStepUp = true;
+	return level - 1;
+}
+
+double QualityController::rateFactor(Step step) {
+	switch(step) {
+		case Stride:
+			return 0.25; // every second sample of every second line
+		case BitDepth16:
+		case BitDepth8:
+		case Decimation:
+		default:
+			return 0.5;
+	}
+}
@@ -0,0 +1,80 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef QUALITYCONTROLLER_H
+#define QUALITYCONTROLLER_H
+
+#include <QVector>
+#include "streamsubscription.h"
+
+#define QUALITY_CONTROLLER_HOLD_SECONDS 3      // uncongested seconds before the quality is stepped up again
+#define QUALITY_CONTROLLER_MAX_HOLD_SECONDS 60 // the hold time doubles each time a step up caused congestion
+#define QUALITY_CONTROLLER_HEADROOM 0.9        // a step up must fit into this fraction of the estimated link capacity
+
+// Automatic quality control of one client (set_adaptive). Level 0 is the
+// subscription as requested by the client, every level above reduces the data
+// rate by one step: bit depth first, then sample and line stride, then buffer
+// decimation, each within the limits of the client's AdaptiveQualitySettings.
+// The Broadcaster calls update() once per second with the drain rate measured
+// from the client's socket, the level is applied with effectiveSubscription().
+class QualityController {
+public:
+	enum Step {
+		BitDepth16,
+		BitDepth8,
+		Stride,
+		Decimation
+	};
+
+	QualityController();
+
+	// sourceBitDepth 0 means it is not known yet, the steps then assume 32-bit data
+	static QVector<Step> steps(const StreamSubscription& subscription, quint8 sourceBitDepth);
+	static StreamSubscription effectiveSubscription(const StreamSubscription& subscription, quint8 sourceBitDepth);
+
+	void reset(quint64 droppedFrames); // back to the initial state, drops up to now are not counted as congestion
+	// returns the new level for the client, droppedFrames is the client's total count
+	int update(const StreamSubscription& subscription, quint8 sourceBitDepth, double drainBytesPerSecond, quint64 droppedFrames, qint64 queuedBytes);
+	double capacityBytesPerSecond() const { return this->capacity; }
+
+private:
+	static double rateFactor(Step step); // data rate after the step relative to before
+
+	quint64 droppedAtLastUpdate;
+	double capacity; // drain rate at the last congestion, 0 = unknown
+	int stableSeconds;
+	int holdSeconds;
+	int secondsSinceChange;
+	bool lastChangeWasStepUp;
+};
+
+#endif // QUALITYCONTROLLER_H
@@ -0,0 +1,184 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "sharedmemoryring.h"
+#include <QDateTime>
+#include <cstring>
+#include <climits>
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
+static_assert(sizeof(RingControl) == 128, "RingControl layout is part of the reader protocol");
+static_assert(sizeof(RingSlotHeader) == 64, "RingSlotHeader layout is part of the reader protocol");
+
+SharedMemoryRing::SharedMemoryRing() : control(nullptr), mapping(nullptr), mappingSize(0), slotCount(0), slotSize(0), slotStride(0), sequence(0) {
+}
+
+SharedMemoryRing::~SharedMemoryRing() {
+	this->destroy();
+}
+
+bool SharedMemoryRing::isSupported() {
+#ifdef Q_OS_UNIX
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool SharedMemoryRing::create(const QString& name, int slotCount, quint64 slotSizeInBytes) {
+	this->destroy();
+#ifdef Q_OS_UNIX
+	quint64 alignment = SHARED_MEMORY_RING_ALIGNMENT;
+	quint64 stride = ((sizeof(RingSlotHeader) + slotSizeInBytes + alignment - 1) / alignment) * alignment;
+	size_t size = sizeof(RingControl) + static_cast<size_t>(stride) * static_cast<size_t>(qMax(1, slotCount));
+
+	// POSIX shared memory names start with a slash and contain no other slash
+	QString shmName = "/" + QString(name).remove('/');
+	QByteArray nativeName = shmName.toLocal8Bit();
+	shm_unlink(nativeName.constData()); // remove a stale object of a previous session
+	int fd = shm_open(nativeName.constData(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if(fd < 0) {
+		this->errorString = QString("shm_open(%1) failed: %2").arg(shmName, QString::fromLocal8Bit(strerror(errno)));
+		return false;
+	}
+	if(ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		this->errorString = QString("Could not resize shared memory %1 to %2 bytes: %3").arg(shmName).arg(size).arg(QString::fromLocal8Bit(strerror(errno)));
+		close(fd);
+		shm_unlink(nativeName.constData());
+		return false;
+	}
+	void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(address == MAP_FAILED) {
+		this->errorString = QString("Could not map shared memory %1: %2").arg(shmName, QString::fromLocal8Bit(strerror(errno)));
+		shm_unlink(nativeName.constData());
+		return false;
+	}
+
+	this->name = shmName;
+	this->mapping = static_cast<char*>(address);
+	this->mappingSize = size;
+	this->slotCount = qMax(1, slotCount);
+	this->slotSize = slotSizeInBytes;
+	this->slotStride = stride;
+	this->sequence = 0;
+
+	memset(this->mapping, 0, sizeof(RingControl));
+	for(int i = 0; i < this->slotCount; i++) {
+		memset(this->mapping + sizeof(RingControl) + static_cast<size_t>(i) * stride, 0, sizeof(RingSlotHeader));
+	}
+	this->control = reinterpret_cast<RingControl*>(this->mapping);
+	this->control->slotCount = static_cast<quint32>(this->slotCount);
+	this->control->controlSize = sizeof(RingControl);
+	this->control->slotSize = slotSizeInBytes;
+	this->control->slotStride = stride;
+	this->control->version = SHARED_MEMORY_RING_VERSION;
+	this->control->writerState = 1;
+	__atomic_store_n(&this->control->magic, static_cast<quint32>(SHARED_MEMORY_RING_MAGIC), __ATOMIC_RELEASE); // readers wait for the magic before trusting the layout
+	return true;
+#else
+	Q_UNUSED(name)
+	Q_UNUSED(slotCount)
+	Q_UNUSED(slotSizeInBytes)
+	this->errorString = "Shared memory transport is only available on Unix systems.";
+	return false;
+#endif
+}
+
+void SharedMemoryRing::destroy() {
+#ifdef Q_OS_UNIX
+	if(this->control) {
+		// tell attached readers that this ring is gone, they reopen it by name
+		__atomic_store_n(&this->control->writerState, 0u, __ATOMIC_RELEASE);
+		this->wakeReaders();
+		munmap(this->mapping, this->mappingSize);
+		shm_unlink(this->name.toLocal8Bit().constData());
+	}
+#endif
+	this->control = nullptr;
+	this->mapping = nullptr;
+	this->mappingSize = 0;
+}
+
+bool SharedMemoryRing::write(const StreamFrame* frame) {
+#ifdef Q_OS_UNIX
+	if(!this->control || frame->sizeInBytes > this->slotSize) {
+		return false;
+	}
+
+	this->sequence++;
+	size_t slotIndex = static_cast<size_t>((this->sequence - 1) % static_cast<quint64>(this->slotCount));
+	char* slot = this->mapping + sizeof(RingControl) + slotIndex * static_cast<size_t>(this->slotStride);
+	RingSlotHeader* slotHeader = reinterpret_cast<RingSlotHeader*>(slot);
+
+	// seqlock write: invalidate the slot, fill it, then publish the new sequence number
+	__atomic_store_n(&slotHeader->sequence, static_cast<quint64>(0), __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	slotHeader->sizeInBytes = frame->sizeInBytes;
+	slotHeader->timestampMs = static_cast<quint64>(QDateTime::currentMSecsSinceEpoch());
+	slotHeader->samplesPerLine = frame->samplesPerLine;
+	slotHeader->linesPerFrame = frame->linesPerFrame;
+	slotHeader->framesPerBuffer = frame->framesPerBuffer;
+	slotHeader->buffersPerVolume = frame->buffersPerVolume;
+	slotHeader->currentBufferNr = frame->currentBufferNr;
+	slotHeader->bitDepth = frame->bitDepth;
+	memcpy(slot + sizeof(RingSlotHeader), frame->data, static_cast<size_t>(frame->sizeInBytes));
+	__atomic_store_n(&slotHeader->sequence, this->sequence, __ATOMIC_RELEASE);
+
+	__atomic_store_n(&this->control->writeSequence, this->sequence, __ATOMIC_RELEASE);
+	this->wakeReaders();
+	return true;
+#else
+	Q_UNUSED(frame)
+	return false;
+#endif
+}
+
+void SharedMemoryRing::wakeReaders() {
+#ifdef Q_OS_UNIX
+	__atomic_add_fetch(&this->control->wakeCounter, 1u, __ATOMIC_SEQ_CST);
+#ifdef Q_OS_LINUX
+	// always woken: the syscall is cheap next to copying the frame, and readers do not have to keep a shared count of waiters correct
+	syscall(SYS_futex, &this->control->wakeCounter, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+#endif
+}
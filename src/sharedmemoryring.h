@@ -0,0 +1,110 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef SHAREDMEMORYRING_H
+#define SHAREDMEMORYRING_H
+
+#include <QString>
+#include <QtGlobal>
+#include "framepool.h"
+
+#define SHARED_MEMORY_RING_MAGIC 0x5254434F // "OCTR" in little-endian byte order
+#define SHARED_MEMORY_RING_VERSION 1
+#define SHARED_MEMORY_RING_ALIGNMENT 64
+
+// Layout of the shared memory region. All fields use the byte order of the
+// host, readers are on the same machine. See examples/octproz_shared_memory_reader.py
+//
+// [RingControl][RingSlotHeader][payload]...[RingSlotHeader][payload]
+struct RingControl {
+	quint32 magic;
+	quint32 version;
+	quint32 slotCount;
+	quint32 controlSize;      // offset of the first slot
+	quint64 slotSize;         // max payload bytes per slot
+	quint64 slotStride;       // bytes from one slot header to the next
+	quint64 writeSequence;    // sequence number of the last completed frame, 0 = no frame yet
+	quint32 wakeCounter;      // incremented after each frame, readers can futex-wait on it
+	quint32 readersWaiting;   // unused, kept for the layout. The writer always wakes, a counter updated by several readers would need atomics in every reader
+	quint32 writerState;      // 1 = writer attached, 0 = ring closed, reopen by name
+	quint32 reserved[19];
+};
+
+struct RingSlotHeader {
+	quint64 sequence;         // frame sequence number, 0 while the slot is being written
+	quint64 sizeInBytes;
+	quint64 timestampMs;      // wall-clock ms since epoch when the frame was written
+	quint32 samplesPerLine;
+	quint32 linesPerFrame;
+	quint32 framesPerBuffer;
+	quint32 buffersPerVolume;
+	quint32 currentBufferNr;
+	quint8 bitDepth;
+	quint8 reserved[19];
+};
+
+// Writer side of the shared memory transport. A POSIX shared memory object
+// holds a ring of frame slots that local readers map without copying.
+// Each slot is guarded like a seqlock: readers compare the slot sequence
+// before and after reading the payload.
+class SharedMemoryRing {
+public:
+	SharedMemoryRing();
+	~SharedMemoryRing();
+
+	bool create(const QString& name, int slotCount, quint64 slotSizeInBytes);
+	void destroy();
+	bool write(const StreamFrame* frame);
+
+	bool isOpen() const { return this->control != nullptr; }
+	QString getName() const { return this->name; }
+	int getSlotCount() const { return this->slotCount; }
+	quint64 getSlotSize() const { return this->slotSize; }
+	QString getErrorString() const { return this->errorString; }
+
+	static bool isSupported();
+
+private:
+	void wakeReaders();
+
+	QString name;
+	QString errorString;
+	RingControl* control;
+	char* mapping;
+	size_t mappingSize;
+	int slotCount;
+	quint64 slotSize;
+	quint64 slotStride;
+	quint64 sequence;
+};
+
+#endif // SHAREDMEMORYRING_H
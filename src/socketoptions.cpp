@@ -0,0 +1,180 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "socketoptions.h"
+#include <QTcpSocket>
+#include <QLocalSocket>
+#ifdef Q_OS_UNIX
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+namespace {
+#ifdef Q_OS_UNIX
+	bool setIntOption(qintptr descriptor, int level, int name, int value) {
+		return ::setsockopt(static_cast<int>(descriptor), level, name, &value, sizeof(value)) == 0;
+	}
+#endif
+
+	// keepalive timing and the low water mark only exist as native options, Qt has no socket option for them
+	void applyNativeTcpOptions(qintptr descriptor, const SocketOptions& options, QStringList& failed) {
+#ifdef Q_OS_UNIX
+		if(options.keepAliveIdleSeconds > 0) {
+#if defined(TCP_KEEPIDLE)
+			if(!setIntOption(descriptor, IPPROTO_TCP, TCP_KEEPIDLE, options.keepAliveIdleSeconds)) {
+				failed << "keepalive_idle";
+			}
+#elif defined(TCP_KEEPALIVE)
+			if(!setIntOption(descriptor, IPPROTO_TCP, TCP_KEEPALIVE, options.keepAliveIdleSeconds)) { // macOS name of TCP_KEEPIDLE
+				failed << "keepalive_idle";
+			}
+#else
+			failed << "keepalive_idle";
+#endif
+#ifdef TCP_KEEPINTVL
+			if(options.keepAliveIntervalSeconds > 0 && !setIntOption(descriptor, IPPROTO_TCP, TCP_KEEPINTVL, options.keepAliveIntervalSeconds)) {
+				failed << "keepalive_interval";
+			}
+#else
+			if(options.keepAliveIntervalSeconds > 0) {
+				failed << "keepalive_interval";
+			}
+#endif
+		}
+#ifdef TCP_NOTSENT_LOWAT
+		if(options.notSentLowatKilobytes > 0 && !setIntOption(descriptor, IPPROTO_TCP, TCP_NOTSENT_LOWAT, options.notSentLowatKilobytes * 1024)) {
+			failed << "notsent_lowat_kb";
+		}
+#else
+		if(options.notSentLowatKilobytes > 0) {
+			failed << "notsent_lowat_kb";
+		}
+#endif
+#ifndef TCP_CORK
+		if(options.cork) {
+			failed << "cork";
+		}
+#endif
+#else
+		Q_UNUSED(descriptor)
+		if(options.keepAliveIdleSeconds > 0) {
+			failed << "keepalive_idle";
+		}
+		if(options.keepAliveIdleSeconds > 0 && options.keepAliveIntervalSeconds > 0) {
+			failed << "keepalive_interval";
+		}
+		if(options.notSentLowatKilobytes > 0) {
+			failed << "notsent_lowat_kb";
+		}
+		if(options.cork) {
+			failed << "cork";
+		}
+#endif
+	}
+}
+
+QStringList SocketTuning::apply(QTcpSocket* socket, const SocketOptions& options) {
+	QStringList failed;
+	if(options.noDelay) {
+		socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+	}
+	if(options.sendBufferKilobytes > 0) {
+		socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, options.sendBufferKilobytes * 1024);
+	}
+	if(options.keepAliveIdleSeconds > 0) {
+		socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+	}
+	applyNativeTcpOptions(socket->socketDescriptor(), options, failed);
+	return failed;
+}
+
+QStringList SocketTuning::apply(QLocalSocket* socket, const SocketOptions& options) {
+	// a local socket is a unix domain socket, on Windows a named pipe that has no send buffer option
+	QStringList failed;
+	if(options.sendBufferKilobytes > 0) {
+#ifdef Q_OS_UNIX
+		if(!setIntOption(socket->socketDescriptor(), SOL_SOCKET, SO_SNDBUF, options.sendBufferKilobytes * 1024)) {
+			failed << "send_buffer_kb";
+		}
+#else
+		Q_UNUSED(socket)
+		failed << "send_buffer_kb";
+#endif
+	}
+	return failed;
+}
+
+QStringList SocketTuning::applyToListener(qintptr descriptor, const SocketOptions& options) {
+	// used for the WebSocket server, QWebSocket does not give access to its socket. Linux copies these options into every accepted connection
+	QStringList failed;
+#ifdef Q_OS_UNIX
+	if(options.noDelay && !setIntOption(descriptor, IPPROTO_TCP, TCP_NODELAY, 1)) {
+		failed << "no_delay";
+	}
+	if(options.sendBufferKilobytes > 0 && !setIntOption(descriptor, SOL_SOCKET, SO_SNDBUF, options.sendBufferKilobytes * 1024)) {
+		failed << "send_buffer_kb";
+	}
+	if(options.keepAliveIdleSeconds > 0 && !setIntOption(descriptor, SOL_SOCKET, SO_KEEPALIVE, 1)) {
+		failed << "keepalive_idle";
+	}
+	applyNativeTcpOptions(descriptor, options, failed);
+#else
+	if(options.noDelay) {
+		failed << "no_delay";
+	}
+	if(options.sendBufferKilobytes > 0) {
+		failed << "send_buffer_kb";
+	}
+	applyNativeTcpOptions(descriptor, options, failed);
+#endif
+	failed.removeDuplicates();
+	failed.removeAll("cork"); // WebSocket clients are not corked, their messages are written by QWebSocket
+	return failed;
+}
+
+bool SocketTuning::setCorked(qintptr descriptor, bool corked) {
+#if defined(Q_OS_UNIX) && defined(TCP_CORK)
+	return setIntOption(descriptor, IPPROTO_TCP, TCP_CORK, corked ? 1 : 0);
+#else
+	Q_UNUSED(descriptor)
+	Q_UNUSED(corked)
+	return false;
+#endif
+}
+
+QString SocketTuning::describe(const SocketOptions& options) {
+	return QString("no_delay=%1 send_buffer_kb=%2 keepalive_idle=%3 keepalive_interval=%4 cork=%5 notsent_lowat_kb=%6")
+		.arg(options.noDelay ? 1 : 0).arg(options.sendBufferKilobytes).arg(options.keepAliveIdleSeconds)
+		.arg(options.keepAliveIntervalSeconds).arg(options.cork ? 1 : 0).arg(options.notSentLowatKilobytes);
+}
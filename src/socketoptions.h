@@ -0,0 +1,77 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef SOCKETOPTIONS_H
+#define SOCKETOPTIONS_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QStringList>
+
+class QTcpSocket;
+class QLocalSocket;
+
+#define SOCKET_SEND_BUFFER_MAX_KILOBYTES 262144 // 256 MB, the kernel caps the size further (net.core.wmem_max on Linux)
+#define SOCKET_KEEPALIVE_MAX_SECONDS 32767      // limit of TCP_KEEPIDLE and TCP_KEEPINTVL on Linux
+#define SOCKET_NOTSENT_LOWAT_MAX_KILOBYTES 65536
+
+// Socket level tuning of the client connections, set in the form or with the
+// set_socket_options command and applied to every new connection.
+// 0 keeps the system default. Options that a transport or platform does not
+// have are skipped: local sockets only have a send buffer, cork needs Linux.
+struct SocketOptions {
+	bool noDelay = false;             // TCP_NODELAY, disables Nagle
+	int sendBufferKilobytes = 0;      // SO_SNDBUF, fixes the size and switches off the kernel's auto tuning
+	int keepAliveIdleSeconds = 0;     // SO_KEEPALIVE with TCP_KEEPIDLE, 0 = no keepalive
+	int keepAliveIntervalSeconds = 0; // TCP_KEEPINTVL between unanswered probes
+	bool cork = false;                // TCP_CORK while more frames are waiting in the send queue
+	int notSentLowatKilobytes = 0;    // TCP_NOTSENT_LOWAT, unsent bytes in the kernel above which the socket is not writable
+
+	bool operator==(const SocketOptions& other) const {
+		return this->noDelay == other.noDelay && this->sendBufferKilobytes == other.sendBufferKilobytes
+			&& this->keepAliveIdleSeconds == other.keepAliveIdleSeconds && this->keepAliveIntervalSeconds == other.keepAliveIntervalSeconds
+			&& this->cork == other.cork && this->notSentLowatKilobytes == other.notSentLowatKilobytes;
+	}
+	bool operator!=(const SocketOptions& other) const { return !(*this == other); }
+};
+
+// Applies SocketOptions to sockets. Each function returns the command keys of
+// the options that could not be set, an empty list if everything was applied.
+namespace SocketTuning {
+	QStringList apply(QTcpSocket* socket, const SocketOptions& options);
+	QStringList apply(QLocalSocket* socket, const SocketOptions& options);
+	QStringList applyToListener(qintptr descriptor, const SocketOptions& options); // accepted TCP connections inherit the options of the listening socket
+	bool setCorked(qintptr descriptor, bool corked);
+	QString describe(const SocketOptions& options);
+}
+
+#endif // SOCKETOPTIONS_H
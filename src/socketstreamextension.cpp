@@ -32,15 +32,22 @@
 
 
 #include "socketstreamextension.h"
+#include "commandparsing.h"
+#include "latencystats.h"
 #include <math.h>
 #include <QtGlobal>
-#include <QFile>
-#include <QTextStream>
+#include <cstring>
+
+#define DEFAULT_FRAME_POOL_SLOTS 10
 
 SocketStreamExtension::SocketStreamExtension() : Extension() {
 	qRegisterMetaType<QVector<qreal> >("QVector<qreal>");
 	qRegisterMetaType<SocketStreamExtensionParameters>("SocketStreamExtensionParameters");
 	qRegisterMetaType<CommunicationMode>("CommunicationMode");
+	qRegisterMetaType<FrameRef>("FrameRef");
+	qRegisterMetaType<DropPolicy>("DropPolicy");
+	qRegisterMetaType<StreamSubscription>("StreamSubscription");
+	qRegisterMetaType<QVector<float> >("QVector<float>");
 
 	//init extension
 	this->setType(EXTENSION);
@@ -54,8 +61,14 @@ SocketStreamExtension::SocketStreamExtension() : Extension() {
 	this->widgetDisplayed = false;
 	connect(this->form, &SocketStreamExtensionForm::paramsChanged, this, &SocketStreamExtension::setParams);
 
+	//frames are copied into pool slots in the data callbacks, so the broadcaster thread never reads OCTproZ's buffer after the callback has returned
+	this->framePool = QSharedPointer<FramePool>::create(DEFAULT_FRAME_POOL_SLOTS);
+
+	this->registerCommands();
+
 	//setup broadcaster gui connections and move broadcaster to thread
 	this->broadcastServer = new Broadcaster();
+	this->broadcastServer->setFramePool(this->framePool);
 	this->broadcastServer->moveToThread(&broadcasterThread);
 	connect(this->broadcastServer, &Broadcaster::info, this, &SocketStreamExtension::info);
 	connect(this->broadcastServer, &Broadcaster::error, this, &SocketStreamExtension::error);
@@ -63,13 +76,25 @@ SocketStreamExtension::SocketStreamExtension() : Extension() {
 	connect(this->form, &SocketStreamExtensionForm::startPressed, this->broadcastServer, &Broadcaster::startBroadcasting);
 	connect(this->form, &SocketStreamExtensionForm::stopPressed, this->broadcastServer, &Broadcaster::stopBroadcasting);
 	connect(this->broadcastServer, &Broadcaster::remoteCommandReceived, this, &SocketStreamExtension::handleRemoteCommand);
+	connect(this->broadcastServer, &Broadcaster::remoteBinaryCommandReceived, this, &SocketStreamExtension::handleRemoteBinaryCommand);
 	connect(&broadcasterThread, &QThread::finished, this->broadcastServer, &Broadcaster::deleteLater);
 	broadcasterThread.start();
+
+	//curve files are read and parsed in a thread of their own, so a large file does not block the GUI
+	this->klinCurveRequest = 0;
+	this->curveLoader = new KLinCurveLoader();
+	this->curveLoader->moveToThread(&curveLoaderThread);
+	connect(this->curveLoader, &KLinCurveLoader::curveLoaded, this, &SocketStreamExtension::onKLinCurveLoaded);
+	connect(this->curveLoader, &KLinCurveLoader::loadFailed, this, &SocketStreamExtension::onKLinCurveLoadFailed);
+	connect(&curveLoaderThread, &QThread::finished, this->curveLoader, &KLinCurveLoader::deleteLater);
+	curveLoaderThread.start();
 }
 
 SocketStreamExtension::~SocketStreamExtension() {
 	broadcasterThread.quit();
 	broadcasterThread.wait();
+	curveLoaderThread.quit();
+	curveLoaderThread.wait();
 
 	if(!this->widgetDisplayed){
 		delete this->form;
@@ -112,108 +137,63 @@ void SocketStreamExtension::storeParameters() {
 
 void SocketStreamExtension::handleRemoteCommand(QString command) {
 	command = command.trimmed();
-
-	if (command.compare("remote_start", Qt::CaseInsensitive) == 0) {
-		emit startProcessingRequest();
-	}
-	else if (command.compare("remote_stop", Qt::CaseInsensitive) == 0) {
-		emit stopProcessingRequest();
-	}
-	else if (command.compare("remote_record", Qt::CaseInsensitive) == 0) {
-		emit startRecordingRequest();
-	}
-	else if (command.startsWith("remote_record:", Qt::CaseInsensitive)) {
-		this->handleRemoteRecordWithParams(command);
-	}
-	else if (command.startsWith("set_rec_path:", Qt::CaseInsensitive)) {
-		this->handleSetRecPathCommand(command);
-	}
-	else if (command.startsWith("set_rec_name:", Qt::CaseInsensitive)) {
-		this->handleSetRecNameCommand(command);
-	}
-	else if (command.startsWith("set_buffers_to_record:", Qt::CaseInsensitive)) {
-		this->handleSetBuffersToRecordCommand(command);
-	}
-	else if (command.startsWith("load_settings", Qt::CaseInsensitive)) {
-		this->handleSettingsCommand(command, "load");
-	}
-	else if (command.startsWith("save_settings", Qt::CaseInsensitive)) {
-		this->handleSettingsCommand(command, "save");
-	}
-	else if(command.startsWith("remote_plugin_control", Qt::CaseInsensitive)){
-		this->handleRemotePluginControlCommand(command);
-	}
-	else if(command.startsWith("set_disp_coeff")) {
-		this->handleSetDispCoeffCommand(command);
-	}
-	else if (command.startsWith("set_grayscale_conversion", Qt::CaseInsensitive)) {
-		this->handleSetGrayscaleConversionCommand(command);
-	}
-	else if(command.startsWith("set_klin_coeffs", Qt::CaseInsensitive)) {
-		this->handleSetKLinCoeffsCommand(command);
-	}
-	else if(command.startsWith("set_klin_curve", Qt::CaseInsensitive)) {
-		this->handleSetKLinCurveCommand(command);
-	}
-	else if(command.startsWith("load_klin_curve", Qt::CaseInsensitive)) {
-		this->handleLoadKLinCurveCommand(command);
-	}
-	else if (command.startsWith("set_rec_options:", Qt::CaseInsensitive)) {
-		this->handleSetRecOptionsCommand(command);
-	}
-	else if (command.startsWith("set_preallocation:", Qt::CaseInsensitive)) {
-		this->handleSetPreallocationCommand(command);
-	}
-	else if (command.startsWith("set_bg_frame", Qt::CaseInsensitive)) {
-		this->handleSetBgFrameCommand(command);
-	}
-	else if (command.startsWith("set_continuous_bg", Qt::CaseInsensitive)) {
-		this->handleSetContinuousBgCommand(command);
-	}
-	else if (command.compare("record_bg_frame", Qt::CaseInsensitive) == 0) {
-		this->handleRecordBgFrameCommand();
-	}
-	else if (command.startsWith("load_bg_frame", Qt::CaseInsensitive)) {
-		this->handleLoadBgFrameCommand(command);
-	}
-	else if (command.startsWith("save_bg_frame", Qt::CaseInsensitive)) {
-		this->handleSaveBgFrameCommand(command);
-	}
-	else if (command.compare("clear_bg_frame", Qt::CaseInsensitive) == 0) {
-		this->handleClearBgFrameCommand();
-	}
-	else if (command.startsWith("set_full_range", Qt::CaseInsensitive)) {
-		this->handleSetFullRangeCommand(command);
-	}
-	else if (command.startsWith("set_cc", Qt::CaseInsensitive)) {
-		this->handleSetCcCommand(command);
-	}
-	else if (command.startsWith("set_raw_only_mode", Qt::CaseInsensitive)) {
-		this->handleSetRawOnlyModeCommand(command);
-	}
-	else if (command.startsWith("set_raw_only_params", Qt::CaseInsensitive)) {
-		this->handleSetRawOnlyParamsCommand(command);
-	}
-	else if (command.startsWith("set_normal_acquisition_params", Qt::CaseInsensitive)) {
-		this->handleSetNormalAcquisitionParamsCommand(command);
-	}
-	else if (command.startsWith("set_camera_control_file_usage", Qt::CaseInsensitive)) {
-		this->handleSetCameraControlFileUsageCommand(command);
-	}
-	else if (command.startsWith("set_camera_control_file", Qt::CaseInsensitive)) {
-		this->handleSetCameraControlFileCommand(command);
-	}
-	else if (command.startsWith("set_camera_params_usage", Qt::CaseInsensitive)) {
-		this->handleSetCameraParamsUsageCommand(command);
+	if (!this->commands.dispatchText(command)) {
+		emit error("Unknown command: " + command);
 	}
-	else if (command.startsWith("set_camera_params", Qt::CaseInsensitive)) {
-		this->handleSetCameraParamsCommand(command);
+	//emit info("Remote command received: " + command);
+}
+
+void SocketStreamExtension::handleRemoteBinaryCommand(quint16 opcode, const QByteArray& payload) {
+	if (!this->commands.dispatchBinary(opcode, payload)) {
+		emit error(QString("Unknown binary command opcode: 0x%1").arg(opcode, 4, 16, QChar('0')));
 	}
-	else if (command.compare("stream_raw", Qt::CaseInsensitive) == 0) {
+}
+
+void SocketStreamExtension::registerCommands() {
+	//text commands are looked up by name, so their order does not matter
+	this->commands.addTextCommand("remote_start", [this](const QString&) { emit startProcessingRequest(); }, CommandMatch::Exact);
+	this->commands.addTextCommand("remote_stop", [this](const QString&) { emit stopProcessingRequest(); }, CommandMatch::Exact);
+	this->commands.addTextCommand("remote_record", [this](const QString& command) {
+		if (command.contains(':')) {
+			this->handleRemoteRecordWithParams(command);
+		} else {
+			emit startRecordingRequest();
+		}
+	}, CommandMatch::ExactOrParameters);
+	this->commands.addTextCommand("set_rec_path", [this](const QString& command) { this->handleSetRecPathCommand(command); });
+	this->commands.addTextCommand("set_rec_name", [this](const QString& command) { this->handleSetRecNameCommand(command); });
+	this->commands.addTextCommand("set_buffers_to_record", [this](const QString& command) { this->handleSetBuffersToRecordCommand(command); });
+	this->commands.addTextCommand("load_settings", [this](const QString& command) { this->handleSettingsCommand(command, "load"); });
+	this->commands.addTextCommand("save_settings", [this](const QString& command) { this->handleSettingsCommand(command, "save"); });
+	this->commands.addTextCommand("remote_plugin_control", [this](const QString& command) { this->handleRemotePluginControlCommand(command); });
+	this->commands.addTextCommand("set_disp_coeff", [this](const QString& command) { this->handleSetDispCoeffCommand(command); });
+	this->commands.addTextCommand("set_grayscale_conversion", [this](const QString& command) { this->handleSetGrayscaleConversionCommand(command); });
+	this->commands.addTextCommand("set_klin_coeffs", [this](const QString& command) { this->handleSetKLinCoeffsCommand(command); });
+	this->commands.addTextCommand("set_klin_curve", [this](const QString& command) { this->handleSetKLinCurveCommand(command); });
+	this->commands.addTextCommand("load_klin_curve", [this](const QString& command) { this->handleLoadKLinCurveCommand(command); });
+	this->commands.addTextCommand("set_rec_options", [this](const QString& command) { this->handleSetRecOptionsCommand(command); });
+	this->commands.addTextCommand("set_preallocation", [this](const QString& command) { this->handleSetPreallocationCommand(command); });
+	this->commands.addTextCommand("set_bg_frame", [this](const QString& command) { this->handleSetBgFrameCommand(command); });
+	this->commands.addTextCommand("set_continuous_bg", [this](const QString& command) { this->handleSetContinuousBgCommand(command); });
+	this->commands.addTextCommand("record_bg_frame", [this](const QString&) { this->handleRecordBgFrameCommand(); }, CommandMatch::Exact);
+	this->commands.addTextCommand("load_bg_frame", [this](const QString& command) { this->handleLoadBgFrameCommand(command); });
+	this->commands.addTextCommand("save_bg_frame", [this](const QString& command) { this->handleSaveBgFrameCommand(command); });
+	this->commands.addTextCommand("clear_bg_frame", [this](const QString&) { this->handleClearBgFrameCommand(); }, CommandMatch::Exact);
+	this->commands.addTextCommand("set_full_range", [this](const QString& command) { this->handleSetFullRangeCommand(command); });
+	this->commands.addTextCommand("set_cc", [this](const QString& command) { this->handleSetCcCommand(command); });
+	this->commands.addTextCommand("set_raw_only_mode", [this](const QString& command) { this->handleSetRawOnlyModeCommand(command); });
+	this->commands.addTextCommand("set_raw_only_params", [this](const QString& command) { this->handleSetRawOnlyParamsCommand(command); });
+	this->commands.addTextCommand("set_normal_acquisition_params", [this](const QString& command) { this->handleSetNormalAcquisitionParamsCommand(command); });
+	this->commands.addTextCommand("set_camera_control_file_usage", [this](const QString& command) { this->handleSetCameraControlFileUsageCommand(command); });
+	this->commands.addTextCommand("set_camera_control_file", [this](const QString& command) { this->handleSetCameraControlFileCommand(command); });
+	this->commands.addTextCommand("set_camera_params_usage", [this](const QString& command) { this->handleSetCameraParamsUsageCommand(command); });
+	this->commands.addTextCommand("set_camera_params", [this](const QString& command) { this->handleSetCameraParamsCommand(command); });
+	this->commands.addTextCommand("set_socket_options", [this](const QString& command) { this->handleSetSocketOptionsCommand(command); });
+	this->commands.addTextCommand("stream_raw", [this](const QString&) {
 		this->restoreProcessedStreamAfterRawOnly.store(0);
 		this->streamRaw.store(1);
-	}
-	else if (command.compare("stream_processed", Qt::CaseInsensitive) == 0) {
+	}, CommandMatch::Exact);
+	this->commands.addTextCommand("stream_processed", [this](const QString&) {
 		this->restoreProcessedStreamAfterRawOnly.store(0);
 		this->streamRaw.store(0);
 		if (this->rawOnlyModeEnabled.load() != 0) {
@@ -222,61 +202,65 @@ void SocketStreamExtension::handleRemoteCommand(QString command) {
 			this->rawOnlyModeEnabled.store(0);
 			emit appCommandRequest("set_raw_only_mode", params);
 		}
-	}
-	else {
-		emit error("Unknown command: " + command);
-	}
-	//emit info("Remote command received: " + command);
-}
-
-bool SocketStreamExtension::parseBoolValue(const QString &value, bool &parsedValue) const {
-	QString normalized = value.trimmed().toLower();
-	if (normalized == "1" || normalized == "true") {
-		parsedValue = true;
-		return true;
-	}
-	if (normalized == "0" || normalized == "false") {
-		parsedValue = false;
-		return true;
-	}
-	return false;
-}
-
-bool SocketStreamExtension::parseKeyValueCommand(const QString &command, QVariantMap &rawParams, QString &errorMessage) const {
-	int colonIndex = command.indexOf(':');
-	if (colonIndex < 0 || colonIndex == command.size() - 1) {
-		errorMessage = "missing parameters";
-		return false;
-	}
+	}, CommandMatch::Exact);
 
-	QStringList parts = command.mid(colonIndex + 1).split(":", QString::SkipEmptyParts);
-	if (parts.isEmpty()) {
-		errorMessage = "missing parameters";
-		return false;
-	}
-
-	for (const QString& part : parts) {
-		int equalsIndex = part.indexOf('=');
-		if (equalsIndex <= 0 || equalsIndex == part.size() - 1) {
-			errorMessage = "invalid key=value pair: " + part.trimmed();
-			return false;
+	//binary commands for clients that update parameters at a high rate, see binarycommand.h
+	this->commands.addBinaryCommand(BinaryOpcode::RemoteStart, [this](BinaryCommandReader&) { emit startProcessingRequest(); });
+	this->commands.addBinaryCommand(BinaryOpcode::RemoteStop, [this](BinaryCommandReader&) { emit stopProcessingRequest(); });
+	this->commands.addBinaryCommand(BinaryOpcode::SetDispCoeff, [this](BinaryCommandReader& payload) {
+		double coeffs[4];
+		double* results[4];
+		if (!this->readBinaryCoefficients(payload, coeffs, results)) {
+			emit error("Invalid binary set_disp_coeff payload, expected 4 x f64.");
+			return;
 		}
-
-		QString key = part.left(equalsIndex).trimmed().toLower();
-		QString value = part.mid(equalsIndex + 1).trimmed();
-		if (key.isEmpty() || value.isEmpty()) {
-			errorMessage = "invalid key=value pair: " + part.trimmed();
-			return false;
+		emit setDispCompCoeffsRequest(results[0], results[1], results[2], results[3]);
+	});
+	this->commands.addBinaryCommand(BinaryOpcode::SetKLinCoeffs, [this](BinaryCommandReader& payload) {
+		double coeffs[4];
+		double* results[4];
+		if (!this->readBinaryCoefficients(payload, coeffs, results)) {
+			emit error("Invalid binary set_klin_coeffs payload, expected 4 x f64.");
+			return;
 		}
-		if (rawParams.contains(key)) {
-			errorMessage = "duplicate key: " + key;
-			return false;
+		emit setKLinCoeffsRequest(results[0], results[1], results[2], results[3]);
+	});
+	this->commands.addBinaryCommand(BinaryOpcode::SetGrayscaleConversion, [this](BinaryCommandReader& payload) {
+		bool enableLogScaling = payload.readU8() != 0;
+		double max = payload.readF64();
+		double min = payload.readF64();
+		double multiplicator = payload.readF64();
+		double offset = payload.readF64();
+		if (!payload.isValid() || !payload.atEnd()) {
+			emit error("Invalid binary set_grayscale_conversion payload, expected u8 and 4 x f64.");
+			return;
 		}
+		emit setGrayscaleConversionRequest(enableLogScaling, max, min, multiplicator, offset);
+	});
+	this->commands.addBinaryCommand(BinaryOpcode::SetKLinCurve, [this](BinaryCommandReader& payload) {
+		//the values are copied into the curve as they are, no text is split or parsed
+		QVector<float> curve;
+		quint32 sampleCount = payload.readU32();
+		if (!payload.readF32Array(curve, sampleCount) || !payload.atEnd()) {
+			emit error("Invalid binary set_klin_curve payload, expected u32 sample count followed by as many f32 values.");
+			return;
+		}
+		if (curve.isEmpty()) {
+			emit error("Empty k-linearization curve data.");
+			return;
+		}
+		this->klinCurveRequest++;
+		emit setCustomResamplingCurveRequest(curve);
+	});
+}
 
-		rawParams.insert(key, value);
+bool SocketStreamExtension::readBinaryCoefficients(BinaryCommandReader& payload, double coeffs[4], double* results[4]) const {
+	//NaN takes the place of "null" in the text command and leaves the coefficient unchanged
+	for (int i = 0; i < 4; i++) {
+		coeffs[i] = payload.readF64();
+		results[i] = qIsNaN(coeffs[i]) ? nullptr : &coeffs[i];
 	}
-
-	return true;
+	return payload.isValid() && payload.atEnd();
 }
 
 void SocketStreamExtension::handleSettingsCommand(const QString& command, const QString& action) {
@@ -307,34 +291,13 @@ void SocketStreamExtension::handleRemotePluginControlCommand(const QString &comm
 }
 
 void SocketStreamExtension::handleSetDispCoeffCommand(const QString& command) {
-		double coeffs[4];
-		double* results[4];
-		bool conversionSuccessful[4];
-		bool success = true;
-
-		QStringList parts = command.toLower().split(":", QString::SkipEmptyParts);
-		if (parts.size() == 5) {
-		parts.removeFirst();
-			for(int i = 0; i < 4; i++){
-				double val = parts[i].toDouble(&(conversionSuccessful[i]));
-				if(conversionSuccessful[i]){
-					coeffs[i] = val;
-					results[i] = &(coeffs[i]);
-				}
-				 else if(parts[i] == "nullptr" || parts[i] == "null") {
-					results[i] = nullptr;
-					conversionSuccessful[i] = true;
-				 }
-				 success = success && conversionSuccessful[i];
-			}
-			if (success) {
-				emit setDispCompCoeffsRequest(results[0], results[1], results[2], results[3]);
-			} else {
-				emit error("One or more coefficients could not be converted to a double.");
-			}
-		} else {
-			emit error("Invalid dispersion coefficients command");
-		}
+	double coeffs[4];
+	bool present[4];
+	if (!CommandParsing::parseCoefficients(command, coeffs, present)) {
+		emit error("Invalid dispersion coefficients command. Expected format: set_disp_coeff:<d0>:<d1>:<d2>:<d3>");
+		return;
+	}
+	emit setDispCompCoeffsRequest(present[0] ? &coeffs[0] : nullptr, present[1] ? &coeffs[1] : nullptr, present[2] ? &coeffs[2] : nullptr, present[3] ? &coeffs[3] : nullptr);
 }
 
 void SocketStreamExtension::handleSetGrayscaleConversionCommand(const QString& command) {
@@ -381,33 +344,12 @@ void SocketStreamExtension::handleSetGrayscaleConversionCommand(const QString& c
 
 void SocketStreamExtension::handleSetKLinCoeffsCommand(const QString& command) {
 	double coeffs[4];
-	double* results[4];
-	bool conversionSuccessful[4];
-	bool success = true;
-
-	QStringList parts = command.toLower().split(":", QString::SkipEmptyParts);
-	if (parts.size() == 5) {
-		parts.removeFirst();
-		for(int i = 0; i < 4; i++){
-			double val = parts[i].toDouble(&(conversionSuccessful[i]));
-			if(conversionSuccessful[i]){
-				coeffs[i] = val;
-				results[i] = &(coeffs[i]);
-			}
-			else if(parts[i] == "nullptr" || parts[i] == "null") {
-				results[i] = nullptr;
-				conversionSuccessful[i] = true;
-			}
-			success = success && conversionSuccessful[i];
-		}
-		if (success) {
-			emit setKLinCoeffsRequest(results[0], results[1], results[2], results[3]);
-		} else {
-			emit error("One or more k-linearization coefficients could not be converted to a double.");
-		}
-	} else {
+	bool present[4];
+	if (!CommandParsing::parseCoefficients(command, coeffs, present)) {
 		emit error("Invalid k-linearization coefficients command. Expected format: set_klin_coeffs:<c0>:<c1>:<c2>:<c3>");
+		return;
 	}
+	emit setKLinCoeffsRequest(present[0] ? &coeffs[0] : nullptr, present[1] ? &coeffs[1] : nullptr, present[2] ? &coeffs[2] : nullptr, present[3] ? &coeffs[3] : nullptr);
 }
 
 void SocketStreamExtension::handleSetKLinCurveCommand(const QString& command) {
@@ -417,19 +359,11 @@ void SocketStreamExtension::handleSetKLinCurveCommand(const QString& command) {
 		return;
 	}
 
-	QString data = command.mid(colonIndex + 1).trimmed();
-	QStringList parts = data.split(",", QString::SkipEmptyParts);
 	QVector<float> curve;
-	curve.reserve(parts.size());
-
-	for (const QString& part : parts) {
-		bool ok;
-		float val = part.trimmed().toFloat(&ok);
-		if (!ok) {
-			emit error("Invalid float value in k-linearization curve: " + part.trimmed());
-			return;
-		}
-		curve.append(val);
+	QString invalidValue;
+	if (!CommandParsing::parseFloatList(command.mid(colonIndex + 1), curve, invalidValue)) {
+		emit error("Invalid float value in k-linearization curve: " + invalidValue);
+		return;
 	}
 
 	if (curve.isEmpty()) {
@@ -437,6 +371,7 @@ void SocketStreamExtension::handleSetKLinCurveCommand(const QString& command) {
 		return;
 	}
 
+	this->klinCurveRequest++;
 	emit setCustomResamplingCurveRequest(curve);
 }
 
@@ -448,32 +383,22 @@ void SocketStreamExtension::handleLoadKLinCurveCommand(const QString& command) {
 	}
 
 	QString fileName = command.mid(colonIndex + 1).trimmed();
-	QFile file(fileName);
-	if (!file.open(QIODevice::ReadOnly)) {
-		emit error("Could not open k-linearization curve file: " + fileName);
-		return;
-	}
-
-	QVector<float> curve;
-	QTextStream txtStream(&file);
-	txtStream.readLine(); // skip header
-	while (!txtStream.atEnd()) {
-		QString line = txtStream.readLine();
-		bool ok;
-		float val = line.section(";", 1, 1).toFloat(&ok);
-		if (ok) {
-			curve.append(val);
-		}
-	}
-	file.close();
+	QMetaObject::invokeMethod(this->curveLoader, "load", Qt::QueuedConnection, Q_ARG(QString, fileName), Q_ARG(quint64, ++this->klinCurveRequest));
+}
 
-	if (curve.isEmpty()) {
-		emit error("K-linearization curve file is empty or has wrong format: " + fileName);
+void SocketStreamExtension::onKLinCurveLoaded(const QString& fileName, quint64 requestId, const QVector<float>& curve, bool fromCache, qint64 elapsedUs) {
+	if (requestId != this->klinCurveRequest) {
+		emit info("K-linearization curve file was replaced by a newer curve before it finished loading: " + fileName);
 		return;
 	}
-
 	emit setCustomResamplingCurveRequest(curve);
-	emit info("Custom k-linearization curve loaded from file: " + fileName);
+	emit info(QString("Custom k-linearization curve loaded from file: %1 (%2 samples, %3 ms%4)").arg(fileName).arg(curve.size()).arg(elapsedUs / 1000.0, 0, 'f', 2).arg(fromCache ? ", cached" : ""));
+}
+
+void SocketStreamExtension::onKLinCurveLoadFailed(const QString& fileName, quint64 requestId, const QString& message) {
+	Q_UNUSED(fileName)
+	Q_UNUSED(requestId)
+	emit error(message);
 }
 
 void SocketStreamExtension::handleSetRecPathCommand(const QString &command) {
@@ -569,7 +494,7 @@ void SocketStreamExtension::handleSetPreallocationCommand(const QString &command
 void SocketStreamExtension::handleSetBgFrameCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_bg_frame command format: " + errorMessage);
 		return;
 	}
@@ -578,7 +503,7 @@ void SocketStreamExtension::handleSetBgFrameCommand(const QString &command) {
 	for (auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
 		if (it.key() == "enable") {
 			bool enable;
-			if (!this->parseBoolValue(it.value().toString(), enable)) {
+			if (!CommandParsing::parseBoolValue(it.value().toString(), enable)) {
 				emit error("Invalid boolean value for set_bg_frame enable: " + it.value().toString());
 				return;
 			}
@@ -618,7 +543,7 @@ void SocketStreamExtension::handleSetBgFrameCommand(const QString &command) {
 void SocketStreamExtension::handleSetContinuousBgCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_continuous_bg command format: " + errorMessage);
 		return;
 	}
@@ -626,7 +551,7 @@ void SocketStreamExtension::handleSetContinuousBgCommand(const QString &command)
 	QVariantMap params;
 	for (auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
 		bool parsedValue;
-		if (!this->parseBoolValue(it.value().toString(), parsedValue)) {
+		if (!CommandParsing::parseBoolValue(it.value().toString(), parsedValue)) {
 			emit error(QString("Invalid boolean value for set_continuous_bg %1: %2").arg(it.key(), it.value().toString()));
 			return;
 		}
@@ -686,7 +611,7 @@ void SocketStreamExtension::handleClearBgFrameCommand() {
 void SocketStreamExtension::handleSetFullRangeCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_full_range command format: " + errorMessage);
 		return;
 	}
@@ -699,7 +624,7 @@ void SocketStreamExtension::handleSetFullRangeCommand(const QString &command) {
 		}
 
 		bool enable;
-		if (!this->parseBoolValue(it.value().toString(), enable)) {
+		if (!CommandParsing::parseBoolValue(it.value().toString(), enable)) {
 			emit error("Invalid boolean value for set_full_range enable: " + it.value().toString());
 			return;
 		}
@@ -712,7 +637,7 @@ void SocketStreamExtension::handleSetFullRangeCommand(const QString &command) {
 void SocketStreamExtension::handleSetCcCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_cc command format: " + errorMessage);
 		return;
 	}
@@ -721,7 +646,7 @@ void SocketStreamExtension::handleSetCcCommand(const QString &command) {
 	for (auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
 		if (it.key() == "enable" || it.key() == "keep_positive") {
 			bool parsedValue;
-			if (!this->parseBoolValue(it.value().toString(), parsedValue)) {
+			if (!CommandParsing::parseBoolValue(it.value().toString(), parsedValue)) {
 				emit error(QString("Invalid boolean value for set_cc %1: %2").arg(it.key(), it.value().toString()));
 				return;
 			}
@@ -768,7 +693,7 @@ bool SocketStreamExtension::parseRawOnlyParams(const QVariantMap &rawParams, QVa
 void SocketStreamExtension::handleSetRawOnlyModeCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_raw_only_mode command format: " + errorMessage);
 		return;
 	}
@@ -779,7 +704,7 @@ void SocketStreamExtension::handleSetRawOnlyModeCommand(const QString &command)
 	}
 
 	bool enable;
-	if (!this->parseBoolValue(rawParams.value("enable").toString(), enable)) {
+	if (!CommandParsing::parseBoolValue(rawParams.value("enable").toString(), enable)) {
 		emit error("Invalid boolean value for set_raw_only_mode enable: " + rawParams.value("enable").toString());
 		return;
 	}
@@ -811,7 +736,7 @@ void SocketStreamExtension::handleSetRawOnlyModeCommand(const QString &command)
 void SocketStreamExtension::handleSetRawOnlyParamsCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_raw_only_params command format: " + errorMessage);
 		return;
 	}
@@ -828,7 +753,7 @@ void SocketStreamExtension::handleSetRawOnlyParamsCommand(const QString &command
 void SocketStreamExtension::handleSetNormalAcquisitionParamsCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_normal_acquisition_params command format: " + errorMessage);
 		return;
 	}
@@ -875,7 +800,7 @@ void SocketStreamExtension::handleSetCameraControlFileCommand(const QString &com
 	QVariantMap rawParams;
 	QString errorMessage;
 	QString prefixCommand = command.left(colonIndex) + ":" + prefix;
-	if (!this->parseKeyValueCommand(prefixCommand, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(prefixCommand, rawParams, errorMessage)) {
 		emit error("Invalid set_camera_control_file command format: " + errorMessage);
 		return;
 	}
@@ -900,7 +825,7 @@ void SocketStreamExtension::handleSetCameraControlFileCommand(const QString &com
 void SocketStreamExtension::handleSetCameraControlFileUsageCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_camera_control_file_usage command format: " + errorMessage);
 		return;
 	}
@@ -917,7 +842,7 @@ void SocketStreamExtension::handleSetCameraControlFileUsageCommand(const QString
 	}
 
 	bool enable;
-	if (!this->parseBoolValue(rawParams.value("enable").toString(), enable)) {
+	if (!CommandParsing::parseBoolValue(rawParams.value("enable").toString(), enable)) {
 		emit error("Invalid boolean value for set_camera_control_file_usage enable: " + rawParams.value("enable").toString());
 		return;
 	}
@@ -931,7 +856,7 @@ void SocketStreamExtension::handleSetCameraControlFileUsageCommand(const QString
 void SocketStreamExtension::handleSetCameraParamsCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_camera_params command format: " + errorMessage);
 		return;
 	}
@@ -986,7 +911,7 @@ void SocketStreamExtension::handleSetCameraParamsCommand(const QString &command)
 void SocketStreamExtension::handleSetCameraParamsUsageCommand(const QString &command) {
 	QVariantMap rawParams;
 	QString errorMessage;
-	if (!this->parseKeyValueCommand(command, rawParams, errorMessage)) {
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
 		emit error("Invalid set_camera_params_usage command format: " + errorMessage);
 		return;
 	}
@@ -1003,7 +928,7 @@ void SocketStreamExtension::handleSetCameraParamsUsageCommand(const QString &com
 	}
 
 	bool enable;
-	if (!this->parseBoolValue(rawParams.value("enable").toString(), enable)) {
+	if (!CommandParsing::parseBoolValue(rawParams.value("enable").toString(), enable)) {
 		emit error("Invalid boolean value for set_camera_params_usage enable: " + rawParams.value("enable").toString());
 		return;
 	}
@@ -1014,6 +939,70 @@ void SocketStreamExtension::handleSetCameraParamsUsageCommand(const QString &com
 	emit appCommandRequest("set_camera_params_usage", params);
 }
 
+void SocketStreamExtension::handleSetSocketOptionsCommand(const QString &command) {
+	// Format: set_socket_options:no_delay=<0|1>:send_buffer_kb=<n>:keepalive_idle=<s>:keepalive_interval=<s>:cork=<0|1>:notsent_lowat_kb=<n>
+	// all keys optional, 0 keeps the system default. Applies to every connection accepted from now on and is stored with the settings
+	QVariantMap rawParams;
+	QString errorMessage;
+	if (!CommandParsing::parseKeyValueCommand(command, rawParams, errorMessage)) {
+		emit error("Invalid set_socket_options command format: " + errorMessage);
+		return;
+	}
+
+	SocketOptions options = this->params.socketOptions;
+	for (auto it = rawParams.cbegin(); it != rawParams.cend(); ++it) {
+		QString value = it.value().toString();
+		if (it.key() == "no_delay" || it.key() == "cork") {
+			bool enable;
+			if (!CommandParsing::parseBoolValue(value, enable)) {
+				emit error(QString("Invalid boolean value for set_socket_options %1: %2").arg(it.key(), value));
+				return;
+			}
+			if (it.key() == "no_delay") {
+				options.noDelay = enable;
+			}
+			else {
+				options.cork = enable;
+			}
+			continue;
+		}
+
+		int* target = nullptr;
+		int maximum = 0;
+		if (it.key() == "send_buffer_kb") {
+			target = &options.sendBufferKilobytes;
+			maximum = SOCKET_SEND_BUFFER_MAX_KILOBYTES;
+		}
+		else if (it.key() == "keepalive_idle") {
+			target = &options.keepAliveIdleSeconds;
+			maximum = SOCKET_KEEPALIVE_MAX_SECONDS;
+		}
+		else if (it.key() == "keepalive_interval") {
+			target = &options.keepAliveIntervalSeconds;
+			maximum = SOCKET_KEEPALIVE_MAX_SECONDS;
+		}
+		else if (it.key() == "notsent_lowat_kb") {
+			target = &options.notSentLowatKilobytes;
+			maximum = SOCKET_NOTSENT_LOWAT_MAX_KILOBYTES;
+		}
+		else {
+			emit error("Unknown set_socket_options parameter: " + it.key());
+			return;
+		}
+		bool ok;
+		int parsedValue = value.toInt(&ok);
+		if (!ok || parsedValue < 0 || parsedValue > maximum) {
+			emit error(QString("Invalid value for set_socket_options %1: %2, expected 0 to %3").arg(it.key(), value).arg(maximum));
+			return;
+		}
+		*target = parsedValue;
+	}
+
+	// through the form, so the widgets show the new options and they are stored like a change made in the gui
+	this->form->setSocketOptions(options);
+	emit info("Socket options for new connections: " + SocketTuning::describe(options));
+}
+
 void SocketStreamExtension::autoConnect() {
 	//get current settings from the form
 	QVariantMap currentSettings;
@@ -1030,57 +1019,46 @@ void SocketStreamExtension::autoConnect() {
 	}
 }
 
+void SocketStreamExtension::broadcastBuffer(void* buffer, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr, bool isRaw) {
+	qint64 receivedNs = LatencyStats::now();
+
+	// numbered before the frame pool is asked for a slot, so clients see a gap in the sequence for buffers that had to be skipped
+	quint64 sequenceNumber = this->bufferSequence.fetchAndAddRelaxed(1) + 1;
+
+	// Calculate bytes per sample
+	size_t bytesPerSample = ceil(static_cast<double>(bitDepth) / 8.0);
+
+	// Calculate total buffer size in bytes
+	size_t bufferSizeInBytes = static_cast<size_t>(samplesPerLine) * linesPerFrame * framesPerBuffer * bytesPerSample;
+
+	// copy the buffer into a preallocated pool slot. If all slots are still in use by slow clients this buffer is skipped
+	FrameRef frame = this->framePool->acquire(bufferSizeInBytes);
+	if(frame.isNull()) {
+		return;
+	}
+	memcpy(frame->data, buffer, bufferSizeInBytes);
+	frame->bitDepth = static_cast<quint8>(bitDepth);
+	frame->samplesPerLine = samplesPerLine;
+	frame->linesPerFrame = linesPerFrame;
+	frame->framesPerBuffer = framesPerBuffer;
+	frame->buffersPerVolume = buffersPerVolume;
+	frame->currentBufferNr = currentBufferNr;
+	frame->sequenceNumber = sequenceNumber;
+	frame->isRaw = isRaw;
+	frame->receivedNs = receivedNs;
+
+	// Invoke the broadcast method, ownership of the frame passes to the broadcaster thread
+	QMetaObject::invokeMethod(this->broadcastServer, "broadcast", Qt::QueuedConnection, Q_ARG(FrameRef, frame));
+}
+
 void SocketStreamExtension::rawDataReceived(void* buffer, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr) {
 	if(this->active && this->streamRaw.load() != 0 && this->rawGrabbingAllowed){
-		Q_UNUSED(buffersPerVolume)
-		Q_UNUSED(currentBufferNr)
-
-		size_t bytesPerSample = ceil(static_cast<double>(bitDepth) / 8.0);
-		size_t bufferSizeInBytes = samplesPerLine * linesPerFrame * framesPerBuffer * bytesPerSample;
-		quint32 quintBufferSizeInBytes = static_cast<quint32>(bufferSizeInBytes);
-
-		quint16 quintFramesPerBuffer = static_cast<quint16>(framesPerBuffer);
-		quint16 quintFrameWidth = static_cast<quint16>(samplesPerLine);
-		quint16 quintFrameHeight = static_cast<quint16>(linesPerFrame);
-		quint8 quintBitDepth = static_cast<quint8>(bitDepth);
-
-		QMetaObject::invokeMethod(this->broadcastServer, "broadcast", Qt::QueuedConnection,
-								  Q_ARG(void*, buffer),
-								  Q_ARG(quint32, quintBufferSizeInBytes),
-								  Q_ARG(quint16, quintFramesPerBuffer),
-								  Q_ARG(quint16, quintFrameWidth),
-								  Q_ARG(quint16, quintFrameHeight),
-								  Q_ARG(quint8, quintBitDepth));
+		this->broadcastBuffer(buffer, bitDepth, samplesPerLine, linesPerFrame, framesPerBuffer, buffersPerVolume, currentBufferNr, true);
 	}
 }
 
 void SocketStreamExtension::processedDataReceived(void* buffer, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr) {
 	if(this->active && this->streamRaw.load() == 0){
-		Q_UNUSED(buffersPerVolume)
-		Q_UNUSED(currentBufferNr)
-
-		// Calculate bytes per sample
-		size_t bytesPerSample = ceil(static_cast<double>(bitDepth) / 8.0);
-
-		// Calculate total buffer size in bytes
-		size_t bufferSizeInBytes = samplesPerLine * linesPerFrame * framesPerBuffer * bytesPerSample;
-
-		// Cast bufferSizeInBytes to quint32 (ensure it does not exceed quint32 limits)
-		quint32 quintBufferSizeInBytes = static_cast<quint32>(bufferSizeInBytes);
-
-		// Cast other parameters to required types
-		quint16 quintFramesPerBuffer = static_cast<quint16>(framesPerBuffer);
-		quint16 quintFrameWidth = static_cast<quint16>(samplesPerLine);
-		quint16 quintFrameHeight = static_cast<quint16>(linesPerFrame);
-		quint8 quintBitDepth = static_cast<quint8>(bitDepth);
-
-		// Invoke the broadcast method with all required parameters
-		QMetaObject::invokeMethod(this->broadcastServer, "broadcast", Qt::QueuedConnection,
-								  Q_ARG(void*, buffer),
-								  Q_ARG(quint32, quintBufferSizeInBytes),
-								  Q_ARG(quint16, quintFramesPerBuffer),
-								  Q_ARG(quint16, quintFrameWidth),
-								  Q_ARG(quint16, quintFrameHeight),
-								  Q_ARG(quint8, quintBitDepth));
+		this->broadcastBuffer(buffer, bitDepth, samplesPerLine, linesPerFrame, framesPerBuffer, buffersPerVolume, currentBufferNr, false);
 	}
 }
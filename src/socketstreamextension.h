@@ -32,6 +32,9 @@
 #include "octproz_devkit.h"
 #include "socketstreamextensionform.h"
 #include "broadcaster.h"
+#include "framepool.h"
+#include "commanddispatcher.h"
+#include "klincurveloader.h"
 
 class SocketStreamExtension : public Extension
 {
@@ -39,6 +42,7 @@ class SocketStreamExtension : public Extension
 	Q_PLUGIN_METADATA(IID Extension_iid)
 	Q_INTERFACES(Extension Plugin)
 	QThread broadcasterThread;
+	QThread curveLoaderThread;
 
 public:
 	SocketStreamExtension();
@@ -58,9 +62,16 @@ private:
 	QAtomicInt streamRaw{0};
 	QAtomicInt rawOnlyModeEnabled{0};
 	QAtomicInt restoreProcessedStreamAfterRawOnly{0};
+	QAtomicInteger<quint64> bufferSequence{0};
 
 	Broadcaster* broadcastServer;
+	QSharedPointer<FramePool> framePool;
+	CommandDispatcher<> commands;
+	KLinCurveLoader* curveLoader;
+	quint64 klinCurveRequest; // incremented by every command that sets the curve, so a file that finishes loading late does not replace a newer curve
 
+	void registerCommands();
+	bool readBinaryCoefficients(BinaryCommandReader &payload, double coeffs[4], double* results[4]) const;
 	void handleSettingsCommand(const QString &command, const QString &action);
 	void handleRemotePluginControlCommand(const QString &command);
 	void handleSetDispCoeffCommand(const QString &command);
@@ -89,15 +100,18 @@ private:
 	void handleSetCameraControlFileUsageCommand(const QString &command);
 	void handleSetCameraParamsCommand(const QString &command);
 	void handleSetCameraParamsUsageCommand(const QString &command);
+	void handleSetSocketOptionsCommand(const QString &command);
 	bool parseRawOnlyParams(const QVariantMap &rawParams, QVariantMap &params, QString &errorMessage) const;
-	bool parseBoolValue(const QString &value, bool &parsedValue) const;
-	bool parseKeyValueCommand(const QString &command, QVariantMap &rawParams, QString &errorMessage) const;
 	void autoConnect();
+	void broadcastBuffer(void* buffer, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr, bool isRaw);
 
 public slots:
 	void setParams(SocketStreamExtensionParameters params);
 	void storeParameters();
 	void handleRemoteCommand(QString command);
+	void handleRemoteBinaryCommand(quint16 opcode, const QByteArray &payload);
+	void onKLinCurveLoaded(const QString &fileName, quint64 requestId, const QVector<float> &curve, bool fromCache, qint64 elapsedUs);
+	void onKLinCurveLoadFailed(const QString &fileName, quint64 requestId, const QString &message);
 
 	virtual void rawDataReceived(void* buffer, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr) override;
 	virtual void processedDataReceived(void* buffer, unsigned int bitDepth, unsigned int samplesPerLine, unsigned int linesPerFrame, unsigned int framesPerBuffer, unsigned int buffersPerVolume, unsigned int currentBufferNr) override;
@@ -38,7 +38,15 @@ SocketStreamExtensionForm::SocketStreamExtensionForm(QWidget *parent) :
 	ui->comboBox_mode->addItem("TCP/IP", QVariant::fromValue(this->toInt(CommunicationMode::TCPIP)));
 	ui->comboBox_mode->addItem("IPC - Local Sockets", QVariant::fromValue(this->toInt(CommunicationMode::IPC)));
 	ui->comboBox_mode->addItem("WebSocket", QVariant::fromValue(this->toInt(CommunicationMode::WebSocket))); // Neuer Modus
+	ui->comboBox_mode->addItem("Shared Memory (same host)", QVariant::fromValue(this->toInt(CommunicationMode::SharedMemory)));
+	ui->comboBox_mode->addItem("UDP Multicast", QVariant::fromValue(this->toInt(CommunicationMode::UdpMulticast)));
+	ui->comboBox_dropPolicy->addItem("Drop oldest", QVariant::fromValue(static_cast<int>(DropPolicy::DropOldest)));
+	ui->comboBox_dropPolicy->addItem("Drop newest", QVariant::fromValue(static_cast<int>(DropPolicy::DropNewest)));
 	connect(ui->comboBox_mode, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SocketStreamExtensionForm::updateGuiAccordingConnectionMode);
+	connect(ui->checkBox_listenTcp, &QCheckBox::toggled, this, &SocketStreamExtensionForm::updateGuiAccordingConnectionMode);
+	connect(ui->checkBox_listenIpc, &QCheckBox::toggled, this, &SocketStreamExtensionForm::updateGuiAccordingConnectionMode);
+	connect(ui->checkBox_listenWebSocket, &QCheckBox::toggled, this, &SocketStreamExtensionForm::updateGuiAccordingConnectionMode);
+	this->broadcastingActive = false;
 	this->updateGuiAccordingConnectionMode();
 
 	//init other gui elements
@@ -59,8 +67,13 @@ SocketStreamExtensionForm::~SocketStreamExtensionForm()
 void SocketStreamExtensionForm::setSettings(QVariantMap settings) {
 	this->ui->lineEdit_ip->setText(settings.value(HOST_IP).toString());
 	this->ui->lineEdit_port->setText(settings.value(HOST_PORT).toString());
+	this->ui->lineEdit_webSocketPort->setText(settings.value(WEBSOCKET_PORT, settings.value(HOST_PORT)).toString()); // older settings used the host port for WebSocket mode
 	this->ui->lineEdit_pipeName->setText(settings.value(PIPE_NAME).toString());
+	this->ui->checkBox_listenTcp->setChecked(settings.value(LISTEN_TCP, false).toBool());
+	this->ui->checkBox_listenIpc->setChecked(settings.value(LISTEN_IPC, false).toBool());
+	this->ui->checkBox_listenWebSocket->setChecked(settings.value(LISTEN_WEBSOCKET, false).toBool());
 	this->ui->checkBox_header->setChecked(settings.value(SEND_HEADER).toBool());
+	this->ui->checkBox_headerV2->setChecked(settings.value(HEADER_VERSION, 1).toInt() == 2);
 
 	int mode = settings.value(CONNECTION_MODE).toInt();
 	int index = ui->comboBox_mode->findData(QVariant::fromValue(mode));
@@ -71,28 +84,113 @@ void SocketStreamExtensionForm::setSettings(QVariantMap settings) {
 	this->ui->checkBox_autoConnect->setChecked(settings.value(AUTO_CONNECT_ENABLED).toBool());
 	this->ui->checkBox_timestamp->setChecked(settings.value(SEND_TIMESTAMP).toBool());
 	this->ui->checkBox_tcpNoDelay->setChecked(settings.value(TCP_NO_DELAY).toBool());
+	this->ui->checkBox_tcpCork->setChecked(settings.value(TCP_CORK, false).toBool());
+	this->ui->spinBox_sendBufferKilobytes->setValue(settings.value(SOCKET_SEND_BUFFER_KILOBYTES, 0).toInt());
+	this->ui->spinBox_keepAliveIdle->setValue(settings.value(TCP_KEEPALIVE_IDLE_SECONDS, 0).toInt());
+	this->ui->spinBox_keepAliveInterval->setValue(settings.value(TCP_KEEPALIVE_INTERVAL_SECONDS, 0).toInt());
+	this->ui->spinBox_notSentLowat->setValue(settings.value(TCP_NOTSENT_LOWAT_KILOBYTES, 0).toInt());
+	this->ui->spinBox_queueFrames->setValue(settings.value(SEND_QUEUE_MAX_FRAMES, 8).toInt());
+	this->ui->spinBox_queueMegabytes->setValue(settings.value(SEND_QUEUE_MAX_MEGABYTES, 1024).toInt());
+	this->ui->spinBox_batchFrames->setValue(settings.value(BATCH_MAX_FRAMES, 1).toInt());
+	this->ui->spinBox_batchKilobytes->setValue(settings.value(BATCH_MAX_KILOBYTES, 1024).toInt());
+	this->ui->spinBox_batchMicroseconds->setValue(settings.value(BATCH_MAX_MICROSECONDS, 0).toInt());
+
+	this->ui->spinBox_sharedMemorySlots->setValue(settings.value(SHARED_MEMORY_SLOTS, 8).toInt());
+	this->ui->spinBox_senderThreads->setValue(settings.value(SENDER_THREADS, 2).toInt());
+	this->ui->lineEdit_multicastGroup->setText(settings.value(MULTICAST_GROUP, "239.255.0.1").toString());
+	this->ui->lineEdit_multicastPort->setText(settings.value(MULTICAST_PORT, 5556).toString());
+	this->ui->spinBox_multicastTtl->setValue(settings.value(MULTICAST_TTL, 1).toInt());
+	this->ui->spinBox_multicastDatagramSize->setValue(settings.value(MULTICAST_DATAGRAM_SIZE, 1472).toInt());
+
+	int dropPolicyIndex = ui->comboBox_dropPolicy->findData(QVariant::fromValue(settings.value(DROP_POLICY, 0).toInt()));
+	if (dropPolicyIndex != -1) {
+		ui->comboBox_dropPolicy->setCurrentIndex(dropPolicyIndex);
+	}
 }
 
 void SocketStreamExtensionForm::getSettings(QVariantMap* settings) {
 	settings->insert(HOST_IP, this->parameters.ip);
 	settings->insert(HOST_PORT, this->parameters.port);
+	settings->insert(WEBSOCKET_PORT, this->parameters.webSocketPort);
 	settings->insert(PIPE_NAME, this->parameters.pipeName);
+	settings->insert(LISTEN_TCP, this->parameters.listenTcp);
+	settings->insert(LISTEN_IPC, this->parameters.listenIpc);
+	settings->insert(LISTEN_WEBSOCKET, this->parameters.listenWebSocket);
 	settings->insert(SEND_HEADER, this->parameters.sendHeader);
+	settings->insert(HEADER_VERSION, this->parameters.headerVersion);
 	settings->insert(CONNECTION_MODE, this->toInt(this->parameters.mode));
 	settings->insert(AUTO_CONNECT_ENABLED, this->parameters.autoConnect);
 	settings->insert(SEND_TIMESTAMP, this->parameters.sendTimestamp);
-	settings->insert(TCP_NO_DELAY, this->parameters.tcpNoDelay);
+	settings->insert(TCP_NO_DELAY, this->parameters.socketOptions.noDelay);
+	settings->insert(TCP_CORK, this->parameters.socketOptions.cork);
+	settings->insert(SOCKET_SEND_BUFFER_KILOBYTES, this->parameters.socketOptions.sendBufferKilobytes);
+	settings->insert(TCP_KEEPALIVE_IDLE_SECONDS, this->parameters.socketOptions.keepAliveIdleSeconds);
+	settings->insert(TCP_KEEPALIVE_INTERVAL_SECONDS, this->parameters.socketOptions.keepAliveIntervalSeconds);
+	settings->insert(TCP_NOTSENT_LOWAT_KILOBYTES, this->parameters.socketOptions.notSentLowatKilobytes);
+	settings->insert(SEND_QUEUE_MAX_FRAMES, this->parameters.sendQueueMaxFrames);
+	settings->insert(SEND_QUEUE_MAX_MEGABYTES, this->parameters.sendQueueMaxMegabytes);
+	settings->insert(DROP_POLICY, static_cast<int>(this->parameters.dropPolicy));
+	settings->insert(BATCH_MAX_FRAMES, this->parameters.batchMaxFrames);
+	settings->insert(BATCH_MAX_KILOBYTES, this->parameters.batchMaxKilobytes);
+	settings->insert(BATCH_MAX_MICROSECONDS, this->parameters.batchMaxMicroseconds);
+	settings->insert(SHARED_MEMORY_SLOTS, this->parameters.sharedMemorySlots);
+	settings->insert(SENDER_THREADS, this->parameters.senderThreads);
+	settings->insert(MULTICAST_GROUP, this->parameters.multicastGroup);
+	settings->insert(MULTICAST_PORT, this->parameters.multicastPort);
+	settings->insert(MULTICAST_TTL, this->parameters.multicastTtl);
+	settings->insert(MULTICAST_DATAGRAM_SIZE, this->parameters.multicastDatagramSize);
+}
+
+void SocketStreamExtensionForm::setSocketOptions(const SocketOptions& options) {
+	//every widget would emit paramsChanged on its own, the new options are sent to the broadcaster and stored once
+	{
+		const QSignalBlocker noDelayBlocker(this->ui->checkBox_tcpNoDelay);
+		const QSignalBlocker corkBlocker(this->ui->checkBox_tcpCork);
+		const QSignalBlocker sendBufferBlocker(this->ui->spinBox_sendBufferKilobytes);
+		const QSignalBlocker keepAliveIdleBlocker(this->ui->spinBox_keepAliveIdle);
+		const QSignalBlocker keepAliveIntervalBlocker(this->ui->spinBox_keepAliveInterval);
+		const QSignalBlocker notSentLowatBlocker(this->ui->spinBox_notSentLowat);
+		this->ui->checkBox_tcpNoDelay->setChecked(options.noDelay);
+		this->ui->checkBox_tcpCork->setChecked(options.cork);
+		this->ui->spinBox_sendBufferKilobytes->setValue(options.sendBufferKilobytes);
+		this->ui->spinBox_keepAliveIdle->setValue(options.keepAliveIdleSeconds);
+		this->ui->spinBox_keepAliveInterval->setValue(options.keepAliveIntervalSeconds);
+		this->ui->spinBox_notSentLowat->setValue(options.notSentLowatKilobytes);
+	}
+	this->updateParams();
 }
 
 void SocketStreamExtensionForm::updateParams() {
 	this->parameters.ip = this->ui->lineEdit_ip->text();
 	this->parameters.port = this->ui->lineEdit_port->text().toInt();
+	this->parameters.webSocketPort = this->ui->lineEdit_webSocketPort->text().toInt();
 	this->parameters.pipeName = this->ui->lineEdit_pipeName->text();
+	this->parameters.listenTcp = this->ui->checkBox_listenTcp->isChecked();
+	this->parameters.listenIpc = this->ui->checkBox_listenIpc->isChecked();
+	this->parameters.listenWebSocket = this->ui->checkBox_listenWebSocket->isChecked();
 	this->parameters.mode = this->fromInt(ui->comboBox_mode->currentData().toInt());
 	this->parameters.autoConnect = this->ui->checkBox_autoConnect->isChecked();
 	this->parameters.sendHeader = this->ui->checkBox_header->isChecked();
+	this->parameters.headerVersion = this->ui->checkBox_headerV2->isChecked() ? 2 : 1;
 	this->parameters.sendTimestamp = this->ui->checkBox_timestamp->isChecked();
-	this->parameters.tcpNoDelay = this->ui->checkBox_tcpNoDelay->isChecked();
+	this->parameters.socketOptions.noDelay = this->ui->checkBox_tcpNoDelay->isChecked();
+	this->parameters.socketOptions.cork = this->ui->checkBox_tcpCork->isChecked();
+	this->parameters.socketOptions.sendBufferKilobytes = this->ui->spinBox_sendBufferKilobytes->value();
+	this->parameters.socketOptions.keepAliveIdleSeconds = this->ui->spinBox_keepAliveIdle->value();
+	this->parameters.socketOptions.keepAliveIntervalSeconds = this->ui->spinBox_keepAliveInterval->value();
+	this->parameters.socketOptions.notSentLowatKilobytes = this->ui->spinBox_notSentLowat->value();
+	this->parameters.sendQueueMaxFrames = this->ui->spinBox_queueFrames->value();
+	this->parameters.sendQueueMaxMegabytes = this->ui->spinBox_queueMegabytes->value();
+	this->parameters.dropPolicy = this->dropPolicyFromInt(ui->comboBox_dropPolicy->currentData().toInt());
+	this->parameters.batchMaxFrames = this->ui->spinBox_batchFrames->value();
+	this->parameters.batchMaxKilobytes = this->ui->spinBox_batchKilobytes->value();
+	this->parameters.batchMaxMicroseconds = this->ui->spinBox_batchMicroseconds->value();
+	this->parameters.sharedMemorySlots = this->ui->spinBox_sharedMemorySlots->value();
+	this->parameters.senderThreads = this->ui->spinBox_senderThreads->value();
+	this->parameters.multicastGroup = this->ui->lineEdit_multicastGroup->text();
+	this->parameters.multicastPort = this->ui->lineEdit_multicastPort->text().toInt();
+	this->parameters.multicastTtl = this->ui->spinBox_multicastTtl->value();
+	this->parameters.multicastDatagramSize = this->ui->spinBox_multicastDatagramSize->value();
 
 	emit paramsChanged(this->parameters);
 }
@@ -107,20 +205,14 @@ void SocketStreamExtensionForm::onStopPressed() {
 }
 
 void SocketStreamExtensionForm::enableButtonsForBroadcastingEnabledState(bool braodcastingActive) {
-	bool isTcpIp = ui->comboBox_mode->currentData().value<int>() == this->toInt(CommunicationMode::TCPIP);
-	bool isWebSocket = ui->comboBox_mode->currentData().value<int>() == this->toInt(CommunicationMode::WebSocket);
-	bool isActive = braodcastingActive;
-	ui->comboBox_mode->setEnabled(!isActive);
+	this->broadcastingActive = braodcastingActive;
+	ui->comboBox_mode->setEnabled(!braodcastingActive);
 
-	ui->pushButton_start->setEnabled(!isActive);
-	ui->pushButton_stop->setEnabled(isActive);
+	ui->pushButton_start->setEnabled(!braodcastingActive);
+	ui->pushButton_stop->setEnabled(braodcastingActive);
+	ui->spinBox_senderThreads->setEnabled(!braodcastingActive);
 
-	//enable or disable IP and Port fields based on TCP/IP or WebSocket mode and broadcasting state
-	ui->lineEdit_ip->setEnabled(!isActive && (isTcpIp || isWebSocket));
-	ui->lineEdit_port->setEnabled(!isActive && (isTcpIp || isWebSocket));
-
-	//enable or disable Pipe Name field based on IPC mode and broadcasting state
-	ui->lineEdit_pipeName->setEnabled(!isActive && !isTcpIp && !isWebSocket);
+	this->updateGuiAccordingConnectionMode();
 }
 
 void SocketStreamExtensionForm::findGuiElements(){
@@ -161,16 +253,39 @@ void SocketStreamExtensionForm::initValidators() {
 					+ "\\." + ipRange + "$");
 	QRegExpValidator *ipValidator = new QRegExpValidator(ipRegex, this);
 	this->ui->lineEdit_ip->setValidator(ipValidator);
+	this->ui->lineEdit_multicastGroup->setValidator(ipValidator);
 
 	this->ui->lineEdit_port->setValidator(new QIntValidator(0, 65535, this));
+	this->ui->lineEdit_webSocketPort->setValidator(new QIntValidator(0, 65535, this));
+	this->ui->lineEdit_multicastPort->setValidator(new QIntValidator(0, 65535, this));
 }
 
 void SocketStreamExtensionForm::updateGuiAccordingConnectionMode() {
 	bool isTcpIp = ui->comboBox_mode->currentData().value<int>() == this->toInt(CommunicationMode::TCPIP);
+	bool isIpc = ui->comboBox_mode->currentData().value<int>() == this->toInt(CommunicationMode::IPC);
 	bool isWebSocket = ui->comboBox_mode->currentData().value<int>() == this->toInt(CommunicationMode::WebSocket);
-	this->ui->lineEdit_ip->setEnabled(isTcpIp || isWebSocket);
-	this->ui->lineEdit_port->setEnabled(isTcpIp || isWebSocket);
-	this->ui->lineEdit_pipeName->setEnabled(!isTcpIp && !isWebSocket);
+	bool isSharedMemory = ui->comboBox_mode->currentData().value<int>() == this->toInt(CommunicationMode::SharedMemory);
+	bool isUdpMulticast = ui->comboBox_mode->currentData().value<int>() == this->toInt(CommunicationMode::UdpMulticast);
+	bool tcpEnabled = isTcpIp || isUdpMulticast || ui->checkBox_listenTcp->isChecked();
+	bool localEnabled = isIpc || isSharedMemory || ui->checkBox_listenIpc->isChecked();
+	bool webSocketEnabled = isWebSocket || ui->checkBox_listenWebSocket->isChecked();
+	bool isActive = this->broadcastingActive;
+
+	//addresses of running servers can not be changed, additional transports can be switched while broadcasting
+	this->ui->lineEdit_ip->setEnabled(!isActive && tcpEnabled);
+	this->ui->lineEdit_port->setEnabled(!isActive && tcpEnabled);
+	this->ui->lineEdit_webSocketPort->setEnabled(!isActive && webSocketEnabled);
+	this->ui->lineEdit_pipeName->setEnabled(!isActive && localEnabled);
+	this->ui->spinBox_sharedMemorySlots->setEnabled(!isActive && isSharedMemory);
+	this->ui->lineEdit_multicastGroup->setEnabled(!isActive && isUdpMulticast);
+	this->ui->lineEdit_multicastPort->setEnabled(!isActive && isUdpMulticast);
+	this->ui->spinBox_multicastTtl->setEnabled(!isActive && isUdpMulticast);
+	this->ui->spinBox_multicastDatagramSize->setEnabled(!isActive && isUdpMulticast);
+
+	//the transport of the selected mode is always served, in multicast mode the tcp server is the control channel
+	this->ui->checkBox_listenTcp->setEnabled(!isTcpIp && !isUdpMulticast);
+	this->ui->checkBox_listenIpc->setEnabled(!isIpc && !isSharedMemory);
+	this->ui->checkBox_listenWebSocket->setEnabled(!isWebSocket);
 }
 
 int SocketStreamExtensionForm::toInt(CommunicationMode mode) {
@@ -185,8 +300,24 @@ CommunicationMode SocketStreamExtensionForm::fromInt(int mode) {
 			return CommunicationMode::IPC;
 		case static_cast<int>(CommunicationMode::WebSocket):
 			return CommunicationMode::WebSocket;
+		case static_cast<int>(CommunicationMode::SharedMemory):
+			return CommunicationMode::SharedMemory;
+		case static_cast<int>(CommunicationMode::UdpMulticast):
+			return CommunicationMode::UdpMulticast;
 		default:
 			emit error("Invalid mode value for CommunicationMode enum.");
 			return CommunicationMode::TCPIP;
 	}
 }
+
+DropPolicy SocketStreamExtensionForm::dropPolicyFromInt(int policy) {
+	switch(policy) {
+		case static_cast<int>(DropPolicy::DropOldest):
+			return DropPolicy::DropOldest;
+		case static_cast<int>(DropPolicy::DropNewest):
+			return DropPolicy::DropNewest;
+		default:
+			emit error("Invalid value for DropPolicy enum.");
+			return DropPolicy::DropOldest;
+	}
+}
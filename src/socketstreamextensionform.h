@@ -36,11 +36,33 @@
 #define HOST_IP "host_ip"
 #define HOST_PORT "host_port"
 #define PIPE_NAME "pipe_name"
+#define WEBSOCKET_PORT "websocket_port"
+#define LISTEN_TCP "listen_tcp"
+#define LISTEN_IPC "listen_ipc"
+#define LISTEN_WEBSOCKET "listen_websocket"
 #define SEND_HEADER "send_header"
+#define HEADER_VERSION "header_version"
 #define SEND_TIMESTAMP "send_timestamp"
 #define TCP_NO_DELAY "tcp_no_delay"
+#define TCP_CORK "tcp_cork"
+#define TCP_KEEPALIVE_IDLE_SECONDS "tcp_keepalive_idle_seconds"
+#define TCP_KEEPALIVE_INTERVAL_SECONDS "tcp_keepalive_interval_seconds"
+#define TCP_NOTSENT_LOWAT_KILOBYTES "tcp_notsent_lowat_kilobytes"
+#define SOCKET_SEND_BUFFER_KILOBYTES "socket_send_buffer_kilobytes"
 #define CONNECTION_MODE "mode"
 #define AUTO_CONNECT_ENABLED "auto_connect_enabled"
+#define SEND_QUEUE_MAX_FRAMES "send_queue_max_frames"
+#define SEND_QUEUE_MAX_MEGABYTES "send_queue_max_megabytes"
+#define DROP_POLICY "drop_policy"
+#define BATCH_MAX_FRAMES "batch_max_frames"
+#define BATCH_MAX_KILOBYTES "batch_max_kilobytes"
+#define BATCH_MAX_MICROSECONDS "batch_max_microseconds"
+#define SHARED_MEMORY_SLOTS "shared_memory_slots"
+#define SENDER_THREADS "sender_threads"
+#define MULTICAST_GROUP "multicast_group"
+#define MULTICAST_PORT "multicast_port"
+#define MULTICAST_TTL "multicast_ttl"
+#define MULTICAST_DATAGRAM_SIZE "multicast_datagram_size"
 
 #include <QWidget>
 #include <QCheckBox>
@@ -66,6 +88,7 @@ public:
 
 	void setSettings(QVariantMap settings);
 	void getSettings(QVariantMap* settings);
+	void setSocketOptions(const SocketOptions& options); // set_socket_options, updates the widgets and emits paramsChanged once
 
 	Ui::SocketStreamExtensionForm* ui;
 
@@ -76,8 +99,10 @@ private:
 	void updateGuiAccordingConnectionMode();
 	int toInt(CommunicationMode mode);
 	CommunicationMode fromInt(int mode);
+	DropPolicy dropPolicyFromInt(int policy);
 
 	SocketStreamExtensionParameters parameters;
+	bool broadcastingActive;
 	QList<QCheckBox*> checkBoxes;
 	QList<QDoubleSpinBox*> doubleSpinBoxes;
 	QList<QSpinBox*> spinBoxes;
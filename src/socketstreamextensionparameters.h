@@ -4,14 +4,27 @@
 #include <QString>
 #include <QtGlobal>
 #include <QMetaType>
+#include "socketoptions.h"
 
 // Enum to choose between
 // inter-process communication (IPC) --> QLocalSockets
 // and TCP/IP communication --> QTcpSocket
+// SharedMemory streams into a POSIX shared memory ring, the local socket is only used for commands
+// UdpMulticast sends every frame once to a multicast group, the TCP server is only used for commands
 enum class CommunicationMode {
 	IPC,
 	TCPIP,
-	WebSocket
+	WebSocket,
+	SharedMemory,
+	UdpMulticast
+};
+
+// What a client's send queue does when it is full:
+// DropOldest discards the oldest queued frame to make room for the new one,
+// DropNewest discards the incoming frame and keeps the queue as it is
+enum class DropPolicy {
+	DropOldest,
+	DropNewest
 };
 
 struct SocketStreamExtensionParameters {
@@ -19,11 +32,29 @@ struct SocketStreamExtensionParameters {
 	QString pipeName;
 	QString ip;
 	quint16 port;
+	quint16 webSocketPort;      // port of the WebSocket server, separate from port so TCP and WebSocket can run side by side
+	bool listenTcp;             // additional transports that are served next to the one selected by mode
+	bool listenIpc;
+	bool listenWebSocket;
 	bool sendHeader;
+	int headerVersion;          // 1 = 13 byte header, 2 = extended header with sequence number and volume position
 	bool sendTimestamp;  // append send-side wall-clock ms to header (requires sendHeader)
-	bool tcpNoDelay;     // disable Nagle on new TCP connections (TCP mode only)
 	bool autoConnect;
+	int sendQueueMaxFrames;     // max frames waiting per client before frames are dropped
+	int sendQueueMaxMegabytes;  // max queued bytes per client in MB, 0 = frame limit only
+	DropPolicy dropPolicy;
+	int batchMaxFrames;         // queued buffers written to a TCP/IPC client in one write, 1 = every buffer on its own
+	int batchMaxKilobytes;      // max bytes of one batched write in KB
+	int batchMaxMicroseconds;   // how long a queued buffer may wait for more buffers, 0 = only batch what is already queued
+	SocketOptions socketOptions; // applied to every new connection, the UDP multicast socket only takes the send buffer size
+	int sharedMemorySlots;      // number of frame slots in the shared memory ring (SharedMemory mode only)
+	int senderThreads;          // threads that write to the clients, 0 = write from the broadcaster thread
+	QString multicastGroup;     // UdpMulticast mode only
+	quint16 multicastPort;
+	int multicastTtl;           // 1 = local network segment only
+	int multicastDatagramSize;  // max bytes per datagram including the fragment header, 1472 fits an Ethernet MTU of 1500
 };
 Q_DECLARE_METATYPE(SocketStreamExtensionParameters)
+Q_DECLARE_METATYPE(DropPolicy)
 
 #endif // SOCKETSTREAMEXTENSIONPARAMETERS_H
@@ -0,0 +1,801 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "streamclient.h"
+#include "frameregion.h"
+#include "bitdepthconverter.h"
+#include "streamheader.h"
+#include "previewencoder.h"
+#include "socketoptions.h"
+#include <QTcpSocket>
+#include <QLocalSocket>
+#include <QHostAddress>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <errno.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+StreamClient::StreamClient(QIODevice* device, QObject* parent) : QObject(parent), device(device), webSocket(nullptr),
+	queueSizeInBytes(0), maxQueuedFrames(1), maxQueuedBytes(0), dropPolicy(DropPolicy::DropOldest), batchMaxFrames(1), batchMaxBytes(0), batchWindowNs(0), batchTimer(nullptr), corking(false), corked(false), droppedFrameCount(0), skippedPreviewCount(0), sentBytes(0), sentFrames(0), drainedBytes(0), writeErrorCount(0), webSocketBytesInFlight(0), suppressedErrors(0), offeredBufferCount(0), nextFrameDueNs(0), inFlightReceivedNs(0), inFlightSerializedNs(0), compressionWatcher(nullptr), compressionCodec(PayloadCompression::None), compressionLevel(0), previewWatcher(nullptr), previewReceivedNs(0), previewSerializedNs(0), commandIdleTimer(new QTimer(this)), terminatesCommands(false) {
+	this->connectionClock.start();
+	this->commandIdleTimer->setSingleShot(true);
+	this->commandIdleTimer->setInterval(STREAM_CLIENT_COMMAND_IDLE_MS);
+	connect(this->commandIdleTimer, &QTimer::timeout, this, &StreamClient::onCommandIdleTimeout);
+	this->device->setParent(this);
+	connect(this->device, &QIODevice::readyRead, this, &StreamClient::onReadyRead);
+	connect(this->device, &QIODevice::bytesWritten, this, &StreamClient::onBytesWritten);
+	if(auto tcpSocket = qobject_cast<QTcpSocket*>(this->device)) {
+		connect(tcpSocket, &QTcpSocket::disconnected, this, &StreamClient::disconnected);
+		this->transport = "tcp";
+		this->peer = QString("%1:%2").arg(tcpSocket->peerAddress().toString()).arg(tcpSocket->peerPort());
+	} else if(auto localSocket = qobject_cast<QLocalSocket*>(this->device)) {
+		connect(localSocket, &QLocalSocket::disconnected, this, &StreamClient::disconnected);
+		this->transport = "ipc";
+		this->peer = localSocket->serverName();
+	}
+}
+
+StreamClient::StreamClient(QWebSocket* webSocket, QObject* parent) : QObject(parent), device(nullptr), webSocket(webSocket),
+	queueSizeInBytes(0), maxQueuedFrames(1), maxQueuedBytes(0), dropPolicy(DropPolicy::DropOldest), batchMaxFrames(1), batchMaxBytes(0), batchWindowNs(0), batchTimer(nullptr), corking(false), corked(false), droppedFrameCount(0), skippedPreviewCount(0), sentBytes(0), sentFrames(0), drainedBytes(0), writeErrorCount(0), webSocketBytesInFlight(0), suppressedErrors(0), offeredBufferCount(0), nextFrameDueNs(0), inFlightReceivedNs(0), inFlightSerializedNs(0), compressionWatcher(nullptr), compressionCodec(PayloadCompression::None), compressionLevel(0), previewWatcher(nullptr), previewReceivedNs(0), previewSerializedNs(0), commandIdleTimer(nullptr), terminatesCommands(false) {
+	this->connectionClock.start();
+	this->transport = "websocket";
+	this->peer = QString("%1:%2").arg(webSocket->peerAddress().toString()).arg(webSocket->peerPort());
+	this->webSocket->setParent(this);
+	connect(this->webSocket, &QWebSocket::textMessageReceived, this, &StreamClient::onTextMessageReceived);
+	connect(this->webSocket, &QWebSocket::binaryMessageReceived, this, &StreamClient::onBinaryMessageReceived);
+	connect(this->webSocket, &QWebSocket::bytesWritten, this, &StreamClient::onBytesWritten);
+	connect(this->webSocket, &QWebSocket::disconnected, this, &StreamClient::disconnected);
+}
+
+StreamClient::~StreamClient() {
+	this->queue.clear();
+}
+
+void StreamClient::setQueueLimits(int maxFrames, qint64 maxBytes, DropPolicy policy) {
+	this->maxQueuedFrames = qMax(1, maxFrames);
+	this->maxQueuedBytes = qMax(static_cast<qint64>(0), maxBytes);
+	this->dropPolicy = policy;
+	if(!this->transformPool.isNull()) {
+		this->transformPool->setSlotCount(this->maxQueuedFrames + 2);
+	}
+}
+
+void StreamClient::setBatchLimits(int maxFrames, qint64 maxBytes, int maxMicroseconds) {
+	this->batchMaxFrames = qBound(1, maxFrames, STREAM_CLIENT_MAX_BATCH_FRAMES);
+	this->batchHeaders.resize(this->batchMaxFrames * STREAM_HEADER_CAPACITY); // client specific headers of adaptive clients
+	this->batchMaxBytes = qMax(static_cast<qint64>(1), maxBytes);
+	this->batchWindowNs = static_cast<qint64>(qMax(0, maxMicroseconds)) * 1000;
+}
+
+void StreamClient::setCorking(bool enabled) {
+	this->corking = enabled && qobject_cast<QTcpSocket*>(this->device) != nullptr;
+	if(!this->corking) {
+		this->setCorked(false);
+	}
+}
+
+void StreamClient::setSubscription(StreamSubscription subscription) {
+	this->subscription = subscription;
+	this->offeredBufferCount = 0;
+	this->nextFrameDueNs = 0;
+	if(!subscription.transformsFrames()) {
+		this->transformPool.reset();
+	} else if(this->transformPool.isNull()) {
+		// one slot per queued frame, plus the frame being written and the one being transformed
+		this->transformPool = QSharedPointer<FramePool>::create(this->maxQueuedFrames + 2);
+	}
+}
+
+void StreamClient::enqueueFrame(FrameRef frame) {
+	if(!this->isWritable() || frame.isNull() || !this->acceptsFrame()) {
+		return;
+	}
+	if(this->subscription.transformsFrames()) {
+		frame = this->transformFrame(frame);
+		if(frame.isNull()) {
+			return;
+		}
+	}
+	if(this->subscription.preview.enabled) {
+		this->encodePreview(frame);
+		return;
+	}
+
+	QueuedFrame queuedFrame = {frame, this->connectionClock.nsecsElapsed()};
+	qint64 frameSizeInBytes = queuedFrame.sizeInBytes();
+
+	// make room for the new frame according to the drop policy. A single frame that is larger than the byte budget is still accepted if the queue is empty, otherwise such a client would never receive anything
+	auto isFull = [this, frameSizeInBytes]() {
+		if(this->queue.isEmpty()) {
+			return false;
+		}
+		bool framesExceeded = this->queue.size() >= this->maxQueuedFrames;
+		bool bytesExceeded = this->maxQueuedBytes > 0 && this->queueSizeInBytes.load() + frameSizeInBytes > this->maxQueuedBytes;
+		return framesExceeded || bytesExceeded;
+	};
+
+	if(isFull()) {
+		if(this->dropPolicy == DropPolicy::DropNewest) {
+			this->droppedFrameCount.fetchAndAddRelaxed(1);
+			return;
+		}
+		while(isFull()) {
+			this->queueSizeInBytes.fetchAndAddRelaxed(-this->queue.dequeue().sizeInBytes());
+			this->droppedFrameCount.fetchAndAddRelaxed(1);
+		}
+	}
+
+	this->queue.enqueue(queuedFrame);
+	this->queueSizeInBytes.fetchAndAddRelaxed(frameSizeInBytes);
+	this->flush();
+}
+
+void StreamClient::encodePreview(const FrameRef& frame) {
+	// only the newest image is of interest: while one is encoded or still on its way to the browser, further frames are skipped
+	// skipped frames are counted separately, as drops they would make set_adaptive step down to the lowest quality although the link keeps up
+	if(!this->webSocket || this->pendingBytes() > 0 || (this->previewWatcher && this->previewWatcher->isRunning())) {
+		this->skippedPreviewCount.fetchAndAddRelaxed(1);
+		return;
+	}
+	if(!this->previewWatcher) {
+		this->previewWatcher = new QFutureWatcher<QByteArray>(this);
+		connect(this->previewWatcher, &QFutureWatcher<QByteArray>::finished, this, &StreamClient::onPreviewEncoded);
+	}
+	this->previewReceivedNs = frame->receivedNs;
+	this->previewSerializedNs = frame->serializedNs;
+	PreviewSettings settings = this->subscription.preview;
+	// the lambda holds the FrameRef, so the pool slot stays valid until the image is encoded, even if this client is deleted in the meantime
+	this->previewWatcher->setFuture(QtConcurrent::run(PreviewEncoder::threadPool(), [frame, settings]() {
+		return PreviewEncoder::encode(frame.data(), settings);
+	}));
+}
+
+void StreamClient::onPreviewEncoded() {
+	QByteArray image = this->previewWatcher->result();
+	if(image.isEmpty() || !this->subscription.preview.enabled || !this->isWritable()) {
+		return;
+	}
+	qint64 sent = this->webSocket->sendBinaryMessage(image);
+	this->webSocketBytesInFlight += sent;
+	this->sentBytes.fetchAndAddRelaxed(static_cast<quint64>(sent));
+	this->sentFrames.fetchAndAddRelaxed(1);
+	this->inFlightReceivedNs = this->previewReceivedNs;
+	this->inFlightSerializedNs = this->previewSerializedNs;
+	if(this->pendingBytes() == 0) {
+		this->recordSendLatency();
+	}
+}
+
+void StreamClient::sendText(const QString& text) {
+	if(this->webSocket) {
+		this->webSocket->sendTextMessage(text);
+	} else if(this->device) {
+		this->device->write(text.toUtf8());
+	}
+}
+
+void StreamClient::close() {
+	this->queue.clear();
+	this->queueSizeInBytes.store(0);
+	this->chunkedTransfer = ChunkedTransfer();
+	this->compressionFrame.clear();
+	if(this->webSocket) {
+		this->webSocket->close();
+	} else if(this->device) {
+		this->device->close();
+	}
+}
+
+void StreamClient::onReadyRead() {
+	//a read can contain several pipelined commands or only a part of one, the framer keeps the rest until its newline arrives
+	qint64 available = this->device->bytesAvailable();
+	if(available <= 0) {
+		return;
+	}
+	qint64 bytesRead = this->device->read(this->commandFramer.prepareAppend(available), available);
+	this->commandFramer.commitAppend(qMax(static_cast<qint64>(0), bytesRead));
+	if(this->emitCommands()) {
+		// a client that terminates its commands may send the rest of a long command after any pause, e.g. on a congested link
+		this->terminatesCommands = true;
+	}
+	if(!this->terminatesCommands && this->commandFramer.hasPending()) {
+		this->commandIdleTimer->start();
+	} else {
+		this->commandIdleTimer->stop();
+	}
+}
+
+void StreamClient::onCommandIdleTimeout() {
+	//clients written against older versions send a command without newline in a single write. Only used until the client sends its first newline
+	QString command = QString::fromUtf8(this->commandFramer.takePending()).trimmed();
+	if(!command.isEmpty()) {
+		emit messageReceived(command);
+	}
+}
+
+void StreamClient::onTextMessageReceived(const QString& message) {
+	//websocket messages are complete, but one message may still hold several newline separated commands
+	this->commandFramer.append(message.toUtf8());
+	this->commandFramer.append(QByteArrayLiteral("\n"));
+	this->emitCommands();
+}
+
+void StreamClient::onBinaryMessageReceived(const QByteArray& message) {
+	this->commandFramer.append(message);
+	if(!message.startsWith(static_cast<char>(BINARY_COMMAND_MARKER))) {
+		this->commandFramer.append(QByteArrayLiteral("\n"));
+	}
+	this->emitCommands();
+}
+
+bool StreamClient::emitCommands() {
+	FramedCommand framed;
+	bool framedAny = false;
+	while(this->commandFramer.next(framed)) {
+		framedAny = true;
+		if(framed.isBinary) {
+			emit binaryCommandReceived(framed.opcode, framed.data);
+			continue;
+		}
+		QString command = QString::fromUtf8(framed.data).trimmed();
+		if(!command.isEmpty()) {
+			emit messageReceived(command);
+		}
+	}
+	if(this->commandFramer.overflowed()) {
+		emit error(tr("Command from %1 exceeds %2 bytes and was discarded").arg(this->peer).arg(COMMAND_FRAMER_MAX_SIZE));
+	}
+	return framedAny;
+}
+
+void StreamClient::onBytesWritten(qint64 bytes) {
+	this->drainedBytes.fetchAndAddRelaxed(static_cast<quint64>(bytes));
+	if(this->webSocket) {
+		this->webSocketBytesInFlight = qMax(static_cast<qint64>(0), this->webSocketBytesInFlight - bytes);
+	}
+	if(this->inFlightSerializedNs > 0 && this->pendingBytes() == 0 && !this->chunkedTransfer.isActive()) {
+		this->recordSendLatency();
+	}
+	this->flush();
+}
+
+bool StreamClient::acceptsFrame() {
+	// temporal decimation happens before anything is queued or serialized for this client
+	this->offeredBufferCount++;
+	if(this->subscription.everyNthBuffer > 1 && (this->offeredBufferCount - 1) % this->subscription.everyNthBuffer != 0) {
+		return false;
+	}
+	double maxFramesPerSecond = this->subscription.effectiveMaxFramesPerSecond();
+	if(maxFramesPerSecond > 0.0) {
+		qint64 intervalNs = qRound64(1.0e9 / maxFramesPerSecond);
+		qint64 nowNs = this->connectionClock.nsecsElapsed();
+		if(nowNs < this->nextFrameDueNs) {
+			return false;
+		}
+		// keep the average rate by scheduling from the due time, but do not catch up after a pause
+		this->nextFrameDueNs = nowNs - this->nextFrameDueNs > intervalNs ? nowNs + intervalNs : this->nextFrameDueNs + intervalNs;
+	}
+	return true;
+}
+
+FrameRef StreamClient::transformFrame(const FrameRef& frame) {
+	const RegionOfInterest& region = this->subscription.region;
+	bool crop = !region.isFullBuffer();
+	bool convert = BitDepthConverter::reducesBitDepth(frame->bitDepth, this->subscription.outputBitDepth);
+	if(!crop && !convert) {
+		return frame;
+	}
+
+	quint32 samples = frame->samplesPerLine;
+	quint32 lines = frame->linesPerFrame;
+	quint32 frames = frame->framesPerBuffer;
+	if(crop && !FrameRegion::outputGeometry(frame.data(), region, samples, lines, frames)) {
+		return FrameRef(); // region lies outside of the current buffer geometry
+	}
+	quint64 sampleCount = static_cast<quint64>(samples) * lines * frames;
+
+	// a cropped region is extracted at the input bit depth and then converted in place, so the slot has to hold the unconverted region
+	quint8 slotBitDepth = crop ? frame->bitDepth : this->subscription.outputBitDepth;
+	FrameRef transformed = this->transformPool->acquire(sampleCount * FrameRegion::bytesPerSample(slotBitDepth));
+	if(transformed.isNull()) {
+		this->droppedFrameCount.fetchAndAddRelaxed(1);
+		return FrameRef();
+	}
+
+	if(crop) {
+		FrameRegion::extract(frame.data(), region, transformed.data());
+	} else {
+		transformed->samplesPerLine = frame->samplesPerLine;
+		transformed->linesPerFrame = frame->linesPerFrame;
+		transformed->framesPerBuffer = frame->framesPerBuffer;
+		transformed->buffersPerVolume = frame->buffersPerVolume;
+		transformed->currentBufferNr = frame->currentBufferNr;
+		transformed->sequenceNumber = frame->sequenceNumber;
+		transformed->isRaw = frame->isRaw;
+		transformed->timestampMs = frame->timestampMs;
+		transformed->bitDepth = frame->bitDepth;
+	}
+	transformed->receivedNs = frame->receivedNs;
+	transformed->serializedNs = frame->serializedNs;
+	if(convert) {
+		const char* input = crop ? transformed->data : frame->data;
+		BitDepthConverter::convert(input, frame->bitDepth, transformed->data, this->subscription.outputBitDepth, sampleCount, this->subscription.windowMin, this->subscription.windowMax);
+		transformed->bitDepth = this->subscription.outputBitDepth;
+		transformed->sizeInBytes = sampleCount * FrameRegion::bytesPerSample(transformed->bitDepth);
+	}
+
+	// the header describes the transformed frame, header options and timestamp are taken over from the full frame
+	StreamHeader::serialize(transformed.data(), frame->headerVersion, StreamHeader::hasTimestamp(frame.data()));
+	if(this->webSocket && this->subscription.compression == PayloadCompression::None && this->subscription.webSocketChunkSize == 0 && !this->subscription.adaptive.enabled) {
+		StreamHeader::buildWebSocketMessage(transformed.data());
+	}
+	return transformed;
+}
+
+void StreamClient::flush() {
+	// only hand the next frame to the socket once the previous one has left its write buffer. Everything beyond that waits in the bounded queue
+	while(this->isWritable() && this->pendingBytes() == 0) {
+		if(this->chunkedTransfer.isActive()) {
+			// a frame that is sent in chunks is finished before the next frame is dequeued, one chunk at a time
+			this->sentBytes.fetchAndAddRelaxed(static_cast<quint64>(this->sendNextChunk()));
+			if(!this->chunkedTransfer.isActive() && this->pendingBytes() == 0) {
+				this->recordSendLatency();
+			}
+			continue;
+		}
+		if(this->queue.isEmpty() || (this->batchesFrames() && !this->batchIsReady())) {
+			// nothing more to write for now, a corked socket sends its last partial segment
+			this->setCorked(false);
+			return;
+		}
+		if(!this->compressionIsReady(this->queue.head().frame)) {
+			// flush() continues in onCompressionFinished, the socket is not kept corked meanwhile
+			this->setCorked(false);
+			return;
+		}
+		this->setCorked(this->corked || this->queue.size() > 1); // a single frame is not corked, it would be uncorked right after the write
+		if(this->batchesFrames()) {
+			if(!this->writeBatch()) {
+				return;
+			}
+			continue;
+		}
+		QueuedFrame queuedFrame = this->queue.dequeue();
+		this->queueSizeInBytes.fetchAndAddRelaxed(-queuedFrame.sizeInBytes());
+		if(!this->fitsWebSocketMessage(queuedFrame.frame)) {
+			continue;
+		}
+		qint64 written = this->sendFrame(queuedFrame.frame);
+		if(written < 0) {
+			this->reportWriteError(tr("Failed to write to client %1: %2").arg(this->peer, this->device->errorString()));
+			return;
+		}
+		this->sentBytes.fetchAndAddRelaxed(static_cast<quint64>(written));
+		this->sentFrames.fetchAndAddRelaxed(1);
+		// the frame counts as sent once the socket's write buffer is empty again, which may only happen in onBytesWritten
+		this->inFlightReceivedNs = queuedFrame.frame->receivedNs;
+		this->inFlightSerializedNs = queuedFrame.frame->serializedNs;
+		if(this->pendingBytes() == 0 && !this->chunkedTransfer.isActive()) {
+			this->recordSendLatency();
+		}
+	}
+}
+
+bool StreamClient::batchesFrames() const {
+	return this->device && this->batchMaxFrames > 1 && this->subscription.batching && this->subscription.compression == PayloadCompression::None;
+}
+
+bool StreamClient::batchIsReady() {
+	// a batch is written when it is full or when its oldest frame has waited for the whole window. With a window of 0 only frames that queued up while the socket was busy are batched
+	int maxFrames = qMin(this->batchMaxFrames, this->maxQueuedFrames);
+	if(this->batchWindowNs <= 0 || this->queue.size() >= maxFrames || this->queueSizeInBytes.load() >= this->batchMaxBytes) {
+		return true;
+	}
+	qint64 waitedNs = this->connectionClock.nsecsElapsed() - this->queue.head().enqueuedNs;
+	if(waitedNs >= this->batchWindowNs) {
+		return true;
+	}
+	// new frames check the window with ns resolution, the timer only writes the rest of a batch when no more frames arrive
+	if(!this->batchTimer) {
+		this->batchTimer = new QTimer(this);
+		this->batchTimer->setSingleShot(true);
+		this->batchTimer->setTimerType(Qt::PreciseTimer);
+		connect(this->batchTimer, &QTimer::timeout, this, &StreamClient::flush);
+	}
+	if(!this->batchTimer->isActive()) {
+		this->batchTimer->start(static_cast<int>((this->batchWindowNs - waitedNs + 999999) / 1000000));
+	}
+	return false;
+}
+
+bool StreamClient::writeBatch() {
+	// several queued frames, header and payload each, go to the socket with a single gathered write
+	this->batchSegments.clear();
+	this->batchFrames.clear();
+	this->inFlightBatch.clear();
+	qint64 batchSize = 0;
+	while(!this->queue.isEmpty() && this->batchFrames.size() < this->batchMaxFrames) {
+		qint64 frameSize = this->queue.head().sizeInBytes();
+		if(!this->batchFrames.isEmpty() && batchSize + frameSize > this->batchMaxBytes) {
+			break;
+		}
+		FrameRef frame = this->queue.dequeue().frame;
+		this->queueSizeInBytes.fetchAndAddRelaxed(-frameSize);
+		const char* header = frame->header;
+		if(this->subscription.adaptive.enabled) {
+			char* clientHeader = this->batchHeaders.data() + this->batchFrames.size() * STREAM_HEADER_CAPACITY;
+			memcpy(clientHeader, frame->header, static_cast<size_t>(frame->headerSize));
+			StreamHeader::setQualityLevel(clientHeader, frame->headerVersion, this->subscription.adaptive.level);
+			header = clientHeader;
+		}
+		this->batchSegments.append({header, frame->headerSize});
+		this->batchSegments.append({frame->data, static_cast<qint64>(frame->sizeInBytes)});
+		this->inFlightBatch.append(qMakePair(frame->receivedNs, frame->serializedNs));
+		this->batchFrames.append(frame);
+		batchSize += frameSize;
+	}
+
+	bool written = this->writeSegments(this->batchSegments.constData(), this->batchSegments.size());
+	int frameCount = this->batchFrames.size();
+	this->inFlightBatch.removeLast(); // the last frame is tracked like a single frame
+	this->inFlightReceivedNs = this->batchFrames.last()->receivedNs;
+	this->inFlightSerializedNs = this->batchFrames.last()->serializedNs;
+	this->batchFrames.clear(); // whatever the kernel did not take was copied into the write buffer, the slots can be reused
+	if(!written) {
+		this->inFlightBatch.clear();
+		this->inFlightReceivedNs = 0;
+		this->inFlightSerializedNs = 0;
+		this->reportWriteError(tr("Failed to write to client %1: %2").arg(this->peer, this->device->errorString()));
+		return false;
+	}
+	this->sentBytes.fetchAndAddRelaxed(static_cast<quint64>(batchSize));
+	this->sentFrames.fetchAndAddRelaxed(static_cast<quint64>(frameCount));
+	if(this->pendingBytes() == 0) {
+		this->recordSendLatency();
+	}
+	return true;
+}
+
+void StreamClient::setCorked(bool corked) {
+	// while corked the kernel only sends full segments, the end of one frame goes out together with the start of the next
+	corked = corked && this->corking;
+	if(corked == this->corked) {
+		return;
+	}
+	auto tcpSocket = qobject_cast<QTcpSocket*>(this->device);
+	if(tcpSocket && SocketTuning::setCorked(tcpSocket->socketDescriptor(), corked)) {
+		this->corked = corked;
+	} else if(corked) {
+		this->corking = false; // not supported, do not try again for every frame
+	}
+}
+
+void StreamClient::recordSendLatency() {
+	if(!this->latencyStats.isNull()) {
+		qint64 nowNs = LatencyStats::now();
+		for(const QPair<qint64, qint64>& frame : qAsConst(this->inFlightBatch)) {
+			this->latencyStats->record(LatencyStats::Send, frame.second, nowNs);
+			this->latencyStats->record(LatencyStats::Total, frame.first, nowNs);
+		}
+		this->latencyStats->record(LatencyStats::Send, this->inFlightSerializedNs, nowNs);
+		this->latencyStats->record(LatencyStats::Total, this->inFlightReceivedNs, nowNs);
+	}
+	this->inFlightBatch.clear();
+	this->inFlightReceivedNs = 0;
+	this->inFlightSerializedNs = 0;
+}
+
+bool StreamClient::fitsWebSocketMessage(const FrameRef& frame) {
+	// a WebSocket message is a single QByteArray, which holds less than 2 GiB. The uncompressed size is checked because the payload is only compressed later and is sent as it is if it does not get smaller
+	if(!this->webSocket || this->subscription.webSocketChunkSize > 0 || STREAM_HEADER_CAPACITY + static_cast<qint64>(frame->sizeInBytes) <= STREAM_WEBSOCKET_MAX_MESSAGE_SIZE) {
+		return true;
+	}
+	this->droppedFrameCount.fetchAndAddRelaxed(1);
+	this->reportWriteError(tr("Buffer of %1 bytes does not fit into a single WebSocket message to client %2 and is dropped, use set_chunking").arg(frame->sizeInBytes).arg(this->peer));
+	return false;
+}
+
+qint64 StreamClient::sendFrame(const FrameRef& frame) {
+	// returns the number of bytes handed to the socket, -1 on error
+	if(this->subscription.compression != PayloadCompression::None && frame->headerSize > 0) {
+		return this->sendCompressedFrame(frame);
+	}
+	if(this->subscription.adaptive.enabled) {
+		// the quality level is client specific, so the client gets its own copy of the shared header
+		char header[STREAM_HEADER_CAPACITY];
+		memcpy(header, frame->header, static_cast<size_t>(frame->headerSize));
+		StreamHeader::setQualityLevel(header, frame->headerVersion, this->subscription.adaptive.level);
+		return this->sendWithHeader(frame, header, frame->headerSize, QByteArray());
+	}
+	if(this->webSocket && this->subscription.webSocketChunkSize > 0) {
+		return this->startChunkedTransfer(frame, frame->header, frame->headerSize, QByteArray());
+	}
+	if(this->webSocket) {
+		qint64 sent = this->webSocket->sendBinaryMessage(frame->webSocketMessage);
+		this->webSocketBytesInFlight += sent;
+		return sent;
+	}
+	qint64 payloadSize = static_cast<qint64>(frame->sizeInBytes);
+	return this->writeFrame(frame->header, frame->headerSize, frame->data, payloadSize) ? frame->headerSize + payloadSize : -1;
+}
+
+bool StreamClient::compressionIsReady(const FrameRef& frame) {
+	// only the frame at the head of the queue is compressed, so frames that are dropped from the queue are never compressed. zlib runs on
+	// PayloadCompression::threadPool(): a large buffer would otherwise hold up the uncompressed clients of this sender thread or, without sender threads, the broadcaster
+	PayloadCompression::Codec codec = this->subscription.compression;
+	int level = this->subscription.compressionLevel;
+	if(codec == PayloadCompression::None || frame->headerSize == 0) {
+		return true;
+	}
+	if(this->compressionWatcher && this->compressionWatcher->isRunning()) {
+		return false;
+	}
+	if(this->compressionFrame == frame && this->compressionCodec == codec && this->compressionLevel == level) {
+		return true;
+	}
+
+	if(!this->compressionWatcher) {
+		this->compressionWatcher = new QFutureWatcher<QByteArray>(this);
+		connect(this->compressionWatcher, &QFutureWatcher<QByteArray>::finished, this, &StreamClient::onCompressionFinished);
+	}
+	this->compressionFrame = frame;
+	this->compressionCodec = codec;
+	this->compressionLevel = level;
+	// the result is kept with the frame and reused by all clients with the same codec and level. The lambda holds the FrameRef, so the slot stays valid even if this client is deleted
+	this->compressionWatcher->setFuture(QtConcurrent::run(PayloadCompression::threadPool(), [frame, codec, level]() {
+		QMutexLocker locker(&frame->compressionMutex);
+		if(frame->compressedCodec != codec || frame->compressionLevel != level) {
+			static thread_local QByteArray shuffleBuffer; // reused by the pool thread
+			frame->compressedPayload = PayloadCompression::compress(frame->data, frame->sizeInBytes, FrameRegion::bytesPerSample(frame->bitDepth), codec, level, shuffleBuffer);
+			frame->compressedCodec = codec;
+			frame->compressionLevel = level;
+		}
+		return frame->compressedPayload;
+	}));
+	return false;
+}
+
+void StreamClient::onCompressionFinished() {
+	this->flush();
+}
+
+qint64 StreamClient::sendCompressedFrame(const FrameRef& frame) {
+	// flush() only gets here once compressionIsReady(), the result of another frame or codec is never used
+	PayloadCompression::Codec codec = this->subscription.compression;
+	QByteArray compressed;
+	if(this->compressionFrame == frame) {
+		compressed = this->compressionWatcher->result();
+		this->compressionFrame.clear(); // the pool slot is free again once the frame is written
+	}
+
+	// payloads that do not get smaller are sent as they are, marked with codec none
+	bool isCompressed = !compressed.isNull();
+	qint64 payloadSize = isCompressed ? compressed.size() : static_cast<qint64>(frame->sizeInBytes);
+	char header[STREAM_HEADER_CAPACITY];
+	memcpy(header, frame->header, static_cast<size_t>(frame->headerSize));
+	if(this->subscription.adaptive.enabled) {
+		StreamHeader::setQualityLevel(header, frame->headerVersion, this->subscription.adaptive.level);
+	}
+	int headerSize = StreamHeader::appendCompression(header, frame->headerSize, frame->headerVersion, isCompressed ? codec : PayloadCompression::None, static_cast<quint64>(payloadSize));
+	return this->sendWithHeader(frame, header, headerSize, compressed);
+}
+
+qint64 StreamClient::sendWithHeader(const FrameRef& frame, const char* header, int headerSize, const QByteArray& compressedPayload) {
+	// sends a client specific header with the frame's payload, or with compressedPayload if that is not null
+	bool isCompressed = !compressedPayload.isNull();
+	const char* payload = isCompressed ? compressedPayload.constData() : frame->data;
+	qint64 payloadSize = isCompressed ? compressedPayload.size() : static_cast<qint64>(frame->sizeInBytes);
+	if(this->webSocket && this->subscription.webSocketChunkSize > 0) {
+		return this->startChunkedTransfer(frame, header, headerSize, compressedPayload);
+	}
+	if(this->webSocket) {
+		QByteArray message;
+		message.reserve(static_cast<int>(headerSize + payloadSize)); // fits, larger frames were dropped by fitsWebSocketMessage
+		message.append(header, headerSize);
+		message.append(payload, static_cast<int>(payloadSize));
+		qint64 sent = this->webSocket->sendBinaryMessage(message);
+		this->webSocketBytesInFlight += sent;
+		return sent;
+	}
+	return this->writeFrame(header, headerSize, payload, payloadSize) ? headerSize + payloadSize : -1;
+}
+
+qint64 StreamClient::startChunkedTransfer(const FrameRef& frame, const char* header, int headerSize, const QByteArray& compressedPayload) {
+	// the next chunk is only handed to the socket once the previous one has left its write buffer (see flush), so neither side has to hold more than about one chunk of a large frame
+	ChunkedTransfer& transfer = this->chunkedTransfer;
+	bool isCompressed = !compressedPayload.isNull();
+	transfer.frame = frame;
+	transfer.header = QByteArray(header, headerSize);
+	transfer.compressedPayload = compressedPayload;
+	transfer.payload = isCompressed ? compressedPayload.constData() : frame->data;
+	transfer.payloadSize = isCompressed ? static_cast<quint64>(compressedPayload.size()) : frame->sizeInBytes;
+
+	// uncompressed chunks are cut at B-scan boundaries, so a client can process whole B-scans while the rest of the buffer is still arriving
+	quint64 chunkSize = this->subscription.webSocketChunkSize;
+	quint64 bscanSize = static_cast<quint64>(frame->samplesPerLine) * frame->linesPerFrame * FrameRegion::bytesPerSample(frame->bitDepth);
+	transfer.chunkPayloadSize = (!isCompressed && bscanSize > 0 && bscanSize <= chunkSize) ? chunkSize / bscanSize * bscanSize : chunkSize;
+	transfer.count = static_cast<quint32>(qMax<quint64>(1, (transfer.payloadSize + transfer.chunkPayloadSize - 1) / transfer.chunkPayloadSize));
+	transfer.index = 0;
+	transfer.sequence++;
+	return this->sendNextChunk();
+}
+
+qint64 StreamClient::sendNextChunk() {
+	ChunkedTransfer& transfer = this->chunkedTransfer;
+	quint64 payloadOffset = static_cast<quint64>(transfer.index) * transfer.chunkPayloadSize;
+	quint64 length = qMin(transfer.chunkPayloadSize, transfer.payloadSize - payloadOffset);
+
+	// the first chunk also carries the stream header. Offsets refer to header and payload as one frame, like a TCP client would receive it
+	int headerSize = transfer.index == 0 ? transfer.header.size() : 0;
+	quint64 frameOffset = transfer.index == 0 ? 0 : transfer.header.size() + payloadOffset;
+	this->chunkMessage.resize(STREAM_CHUNK_HEADER_SIZE + headerSize + static_cast<int>(length));
+	char* message = this->chunkMessage.data();
+	StreamHeader::serializeChunkHeader(message, transfer.sequence, transfer.index, transfer.count, transfer.header.size() + transfer.payloadSize, frameOffset);
+	memcpy(message + STREAM_CHUNK_HEADER_SIZE, transfer.header.constData(), static_cast<size_t>(headerSize));
+	memcpy(message + STREAM_CHUNK_HEADER_SIZE + headerSize, transfer.payload + payloadOffset, static_cast<size_t>(length));
+	qint64 sent = this->webSocket->sendBinaryMessage(this->chunkMessage);
+	this->webSocketBytesInFlight += sent;
+
+	transfer.index++;
+	if(!transfer.isActive()) {
+		transfer.frame.clear(); // the pool slot is free again
+		transfer.compressedPayload = QByteArray();
+		transfer.payload = nullptr;
+	}
+	return sent;
+}
+
+void StreamClient::reportWriteError(const QString& message) {
+	// a broken connection fails on every frame, so errors are counted and reported at most once per second
+	this->writeErrorCount.fetchAndAddRelaxed(1);
+	if(this->errorReportClock.isValid() && this->errorReportClock.elapsed() < 1000) {
+		this->suppressedErrors++;
+		return;
+	}
+	if(this->suppressedErrors > 0) {
+		emit error(tr("%1 (%2 similar errors suppressed)").arg(message).arg(this->suppressedErrors));
+	} else {
+		emit error(message);
+	}
+	this->suppressedErrors = 0;
+	this->errorReportClock.start();
+}
+
+bool StreamClient::writeFrame(const char* header, qint64 headerSize, const char* payload, qint64 payloadSize) {
+	WriteSegment segments[2] = {{header, headerSize}, {payload, payloadSize}};
+	return this->writeSegments(segments, 2);
+}
+
+bool StreamClient::writeSegments(const WriteSegment* segments, int count) {
+	// write straight from the frame slots to the socket. Only what the kernel does not take right away is copied into the write buffer of the QIODevice
+	qint64 written = this->writeNative(segments, count);
+	if(written < 0) {
+		return false;
+	}
+	this->drainedBytes.fetchAndAddRelaxed(static_cast<quint64>(written)); // bytes the kernel took directly, they never show up in bytesWritten
+	for(int i = 0; i < count; i++) {
+		if(written >= segments[i].size) {
+			written -= segments[i].size;
+			continue;
+		}
+		if(this->device->write(segments[i].data + written, segments[i].size - written) == -1) {
+			return false;
+		}
+		written = 0;
+	}
+	return true;
+}
+
+qint64 StreamClient::writeNative(const WriteSegment* segments, int count) {
+#ifdef Q_OS_UNIX
+	// bypassing the QIODevice is only allowed while its write buffer is empty, otherwise the byte order on the wire would break
+	if(this->device->bytesToWrite() > 0) {
+		return 0;
+	}
+	qintptr descriptor = -1;
+	if(auto tcpSocket = qobject_cast<QTcpSocket*>(this->device)) {
+		descriptor = tcpSocket->socketDescriptor();
+	} else if(auto localSocket = qobject_cast<QLocalSocket*>(this->device)) {
+		descriptor = localSocket->socketDescriptor();
+	}
+	if(descriptor < 0 || count > 2 * STREAM_CLIENT_MAX_BATCH_FRAMES) {
+		return 0;
+	}
+
+	qint64 totalSize = 0;
+	for(int i = 0; i < count; i++) {
+		totalSize += segments[i].size;
+	}
+
+	// sockets are non-blocking, so the loop ends as soon as the kernel send buffer is full
+	struct iovec remaining[2 * STREAM_CLIENT_MAX_BATCH_FRAMES];
+	qint64 totalWritten = 0;
+	int firstSegment = 0;
+	qint64 firstOffset = 0; // bytes of the first segment that were already written
+	while(totalWritten < totalSize) {
+		int segmentCount = 0;
+		for(int i = firstSegment; i < count; i++) {
+			qint64 offset = i == firstSegment ? firstOffset : 0;
+			remaining[segmentCount].iov_base = const_cast<char*>(segments[i].data) + offset;
+			remaining[segmentCount].iov_len = static_cast<size_t>(segments[i].size - offset);
+			segmentCount++;
+		}
+		struct msghdr message = {};
+		message.msg_iov = remaining;
+		message.msg_iovlen = segmentCount;
+		ssize_t result = ::sendmsg(static_cast<int>(descriptor), &message, MSG_NOSIGNAL); // scatter/gather write, MSG_NOSIGNAL because a closed peer must not raise SIGPIPE
+		if(result < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			if(errno == EAGAIN || errno == EWOULDBLOCK) {
+				break;
+			}
+			return -1;
+		}
+		totalWritten += result;
+		qint64 advance = result;
+		while(firstSegment < count && advance >= segments[firstSegment].size - firstOffset) {
+			advance -= segments[firstSegment].size - firstOffset;
+			firstSegment++;
+			firstOffset = 0;
+		}
+		firstOffset += advance;
+	}
+	return totalWritten;
+#else
+	Q_UNUSED(segments)
+	Q_UNUSED(count)
+	return 0;
+#endif
+}
+
+bool StreamClient::isWritable() const {
+	if(this->webSocket) {
+		return this->webSocket->isValid();
+	}
+	return this->device && this->device->isOpen();
+}
+
+qint64 StreamClient::pendingBytes() const {
+	if(this->webSocket) {
+		return this->webSocketBytesInFlight;
+	}
+	return this->device->bytesToWrite();
+}
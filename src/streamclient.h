@@ -0,0 +1,215 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef STREAMCLIENT_H
+#define STREAMCLIENT_H
+
+#include <QObject>
+#include <QIODevice>
+#include <QWebSocket>
+#include <QQueue>
+#include <QVector>
+#include <QPair>
+#include <QByteArray>
+#include <QString>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QFutureWatcher>
+#include "socketstreamextensionparameters.h"
+#include "framepool.h"
+#include "streamsubscription.h"
+#include "latencystats.h"
+#include "commandframer.h"
+
+#define STREAM_CLIENT_COMMAND_IDLE_MS 100 // unterminated input of a client that never sent a newline is taken as a command after this time
+#define STREAM_CLIENT_MAX_BATCH_FRAMES 512 // two iovec segments per frame, IOV_MAX is 1024 on Linux
+
+// Frame waiting in a client's send queue. Header and payload stay in the
+// frame pool slot until the frame has been written.
+struct QueuedFrame {
+	FrameRef frame;
+	qint64 enqueuedNs; // connection clock, start of the batching window
+
+	qint64 sizeInBytes() const { return this->frame->headerSize + static_cast<qint64>(this->frame->sizeInBytes); }
+};
+
+// Part of a gathered write, points into a frame pool slot.
+struct WriteSegment {
+	const char* data;
+	qint64 size;
+};
+
+// Frame that is sent to a WebSocket client as a series of chunk messages
+// (set_chunking). Holds the frame until its last chunk has been handed to the socket.
+struct ChunkedTransfer {
+	FrameRef frame;
+	QByteArray header;               // stream header incl. compression fields, sent with the first chunk
+	QByteArray compressedPayload;    // null if the payload is sent uncompressed from the frame
+	const char* payload = nullptr;
+	quint64 payloadSize = 0;
+	quint64 chunkPayloadSize = 0;
+	quint32 sequence = 0;
+	quint32 index = 0;
+	quint32 count = 0;
+
+	bool isActive() const { return this->index < this->count; }
+};
+
+// One connected client of the Broadcaster. Owns the underlying socket and a
+// bounded send queue, so a slow consumer loses frames instead of letting the
+// socket's write buffer grow without limit.
+// A StreamClient may live in a sender thread of its own. Other threads must
+// only call its slots through queued invocations, the counters are atomic.
+class StreamClient : public QObject {
+	Q_OBJECT
+
+public:
+	explicit StreamClient(QIODevice* device, QObject* parent = nullptr);
+	explicit StreamClient(QWebSocket* webSocket, QObject* parent = nullptr);
+	~StreamClient();
+
+	bool isWebSocket() const { return this->webSocket != nullptr; }
+	qint64 queuedBytes() const { return this->queueSizeInBytes.load(); }
+	quint64 droppedFrames() const { return this->droppedFrameCount.load(); }
+	quint64 skippedPreviews() const { return this->skippedPreviewCount.load(); } // not counted as dropped frames, skipping is how the preview keeps its rate
+	quint64 bytesSent() const { return this->sentBytes.load(); }
+	quint64 framesSent() const { return this->sentFrames.load(); }
+	quint64 bytesDrained() const { return this->drainedBytes.load(); } // bytes that left the socket's write buffer
+	quint64 writeErrors() const { return this->writeErrorCount.load(); }
+	qint64 connectedMs() const { return this->connectionClock.elapsed(); }
+	QString transportName() const { return this->transport; }
+	QString peerName() const { return this->peer; }
+	void setLatencyStats(QSharedPointer<LatencyStats> stats) { this->latencyStats = stats; } // before the client is moved to its sender thread
+
+signals:
+	void messageReceived(const QString& message);
+	void binaryCommandReceived(quint16 opcode, const QByteArray& payload);
+	void disconnected();
+	void error(const QString message);
+
+public slots:
+	void setQueueLimits(int maxFrames, qint64 maxBytes, DropPolicy policy);
+	void setBatchLimits(int maxFrames, qint64 maxBytes, int maxMicroseconds);
+	void setCorking(bool enabled);
+	void setSubscription(StreamSubscription subscription);
+	void enqueueFrame(FrameRef frame);
+	void sendText(const QString& text);
+	void close();
+
+private slots:
+	void onReadyRead();
+	void onCommandIdleTimeout();
+	void onPreviewEncoded();
+	void onCompressionFinished();
+	void onTextMessageReceived(const QString& message);
+	void onBinaryMessageReceived(const QByteArray& message);
+	void onBytesWritten(qint64 bytes);
+
+private:
+	bool acceptsFrame();
+	FrameRef transformFrame(const FrameRef& frame);
+	void flush();
+	bool batchesFrames() const;
+	bool batchIsReady();
+	bool writeBatch();
+	void setCorked(bool corked);
+	bool fitsWebSocketMessage(const FrameRef& frame);
+	qint64 sendFrame(const FrameRef& frame);
+	void recordSendLatency();
+	bool compressionIsReady(const FrameRef& frame);
+	qint64 sendCompressedFrame(const FrameRef& frame);
+	qint64 sendWithHeader(const FrameRef& frame, const char* header, int headerSize, const QByteArray& compressedPayload);
+	qint64 startChunkedTransfer(const FrameRef& frame, const char* header, int headerSize, const QByteArray& compressedPayload);
+	qint64 sendNextChunk();
+	void reportWriteError(const QString& message);
+	bool writeFrame(const char* header, qint64 headerSize, const char* payload, qint64 payloadSize);
+	bool writeSegments(const WriteSegment* segments, int count);
+	qint64 writeNative(const WriteSegment* segments, int count);
+	bool isWritable() const;
+	qint64 pendingBytes() const;
+	bool emitCommands(); // true if at least one complete command was framed
+	void encodePreview(const FrameRef& frame);
+
+	QIODevice* device;
+	QWebSocket* webSocket;
+
+	QQueue<QueuedFrame> queue;
+	QAtomicInteger<qint64> queueSizeInBytes;
+	int maxQueuedFrames;
+	qint64 maxQueuedBytes;
+	DropPolicy dropPolicy;
+	int batchMaxFrames;
+	qint64 batchMaxBytes;
+	qint64 batchWindowNs;
+	QTimer* batchTimer; // created with the first batching window, flushes a batch that did not fill up in time
+	QVector<WriteSegment> batchSegments;
+	QVector<FrameRef> batchFrames;
+	QByteArray batchHeaders;
+	bool corking; // SocketOptions::cork, TCP clients only
+	bool corked;
+	QVector<QPair<qint64, qint64>> inFlightBatch; // received and serialized time of the frames of the last batch, except the last frame
+	QAtomicInteger<quint64> droppedFrameCount;
+	QAtomicInteger<quint64> skippedPreviewCount;
+	QAtomicInteger<quint64> sentBytes;
+	QAtomicInteger<quint64> sentFrames;
+	QAtomicInteger<quint64> drainedBytes;
+	QAtomicInteger<quint64> writeErrorCount;
+	qint64 webSocketBytesInFlight;
+	ChunkedTransfer chunkedTransfer;
+	QByteArray chunkMessage; // reused for every chunk, keeps its capacity
+	QString transport;
+	QString peer;
+	QElapsedTimer errorReportClock;
+	int suppressedErrors;
+
+	StreamSubscription subscription;
+	quint64 offeredBufferCount;
+	QElapsedTimer connectionClock; // started on connect, also the time base of the rate limit
+	qint64 nextFrameDueNs;
+	QSharedPointer<LatencyStats> latencyStats;
+	qint64 inFlightReceivedNs; // timestamps of the frame in the socket's write buffer, 0 if there is none
+	qint64 inFlightSerializedNs;
+	QFutureWatcher<QByteArray>* compressionWatcher; // created with the first compressed frame, at most one frame of this client is compressed at a time
+	FrameRef compressionFrame; // frame that compressionWatcher compresses or has compressed, null if none
+	PayloadCompression::Codec compressionCodec; // codec and level compressionFrame is compressed with
+	int compressionLevel;
+	QFutureWatcher<QByteArray>* previewWatcher; // created with the first preview image, at most one image is encoded at a time
+	qint64 previewReceivedNs;
+	qint64 previewSerializedNs;
+	CommandFramer commandFramer;
+	QTimer* commandIdleTimer;
+	bool terminatesCommands; // set with the first newline terminated or binary command from this client, the idle fallback is only used for clients that never sent one
+	QSharedPointer<FramePool> transformPool; // slots for the cropped or converted copies of this client, only used if the subscription transforms frames
+};
+
+#endif // STREAMCLIENT_H
@@ -0,0 +1,133 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "streamheader.h"
+#include <QtEndian>
+#include <cstring>
+
+void StreamHeader::serialize(StreamFrame* frame, int version, bool includeTimestamp) {
+	// header is written into the slot's own header buffer, so no allocation is needed per frame
+	uchar* header = reinterpret_cast<uchar*>(frame->header);
+	int size = 0;
+	if(version == 1) {
+		qToBigEndian<quint32>(STREAM_START_IDENTIFIER, header + size); size += 4;
+		qToBigEndian<quint32>(static_cast<quint32>(frame->sizeInBytes), header + size); size += 4;
+		qToBigEndian<quint16>(static_cast<quint16>(frame->samplesPerLine), header + size); size += 2;
+		qToBigEndian<quint16>(static_cast<quint16>(frame->linesPerFrame), header + size); size += 2;
+		header[size] = frame->bitDepth; size += 1;
+	} else if(version == 2) {
+		quint16 flags = (frame->isRaw ? STREAM_HEADER_V2_FLAG_RAW : 0) | (includeTimestamp ? STREAM_HEADER_V2_FLAG_TIMESTAMP : 0);
+		quint16 headerSize = STREAM_HEADER_V2_BASE_SIZE + (includeTimestamp ? STREAM_HEADER_TIMESTAMP_SIZE : 0);
+		qToBigEndian<quint32>(STREAM_START_IDENTIFIER_V2, header + size); size += 4;
+		qToBigEndian<quint16>(2, header + size); size += 2;
+		qToBigEndian<quint16>(headerSize, header + size); size += 2;
+		qToBigEndian<quint16>(flags, header + size); size += 2;
+		header[size] = frame->bitDepth; size += 1;
+		header[size] = 0; size += 1;
+		qToBigEndian<quint64>(frame->sequenceNumber, header + size); size += 8;
+		qToBigEndian<quint64>(frame->sizeInBytes, header + size); size += 8;
+		qToBigEndian<quint32>(frame->samplesPerLine, header + size); size += 4;
+		qToBigEndian<quint32>(frame->linesPerFrame, header + size); size += 4;
+		qToBigEndian<quint32>(frame->framesPerBuffer, header + size); size += 4;
+		qToBigEndian<quint32>(frame->buffersPerVolume, header + size); size += 4;
+		qToBigEndian<quint32>(frame->currentBufferNr, header + size); size += 4;
+	}
+	if(version > 0 && includeTimestamp) {
+		// Send-side wall-clock ms since epoch. Consumed by measure_delay.py
+		// to compute the send->recv latency.
+		qToBigEndian<quint64>(frame->timestampMs, header + size); size += STREAM_HEADER_TIMESTAMP_SIZE;
+	}
+	frame->headerVersion = version;
+	frame->headerSize = size;
+}
+
+bool StreamHeader::hasTimestamp(const StreamFrame* frame) {
+	switch(frame->headerVersion) {
+		case 1:
+			return frame->headerSize > STREAM_HEADER_BASE_SIZE;
+		case 2:
+			return frame->headerSize > STREAM_HEADER_V2_BASE_SIZE;
+		default:
+			return false;
+	}
+}
+
+void StreamHeader::buildWebSocketMessage(StreamFrame* frame) {
+	qint64 messageSize = frame->headerSize + static_cast<qint64>(frame->sizeInBytes);
+	if(messageSize > STREAM_WEBSOCKET_MAX_MESSAGE_SIZE) {
+		frame->webSocketMessage.clear(); // the clients drop such frames, see StreamClient::fitsWebSocketMessage
+		return;
+	}
+	frame->webSocketMessage.resize(static_cast<int>(messageSize)); // keeps the capacity of the previous use of this slot
+	char* message = frame->webSocketMessage.data();
+	memcpy(message, frame->header, static_cast<size_t>(frame->headerSize));
+	memcpy(message + frame->headerSize, frame->data, static_cast<size_t>(frame->sizeInBytes));
+}
+
+int StreamHeader::appendCompression(char* header, int headerSize, int version, PayloadCompression::Codec codec, quint64 payloadSize) {
+	uchar* fields = reinterpret_cast<uchar*>(header + headerSize);
+	fields[0] = static_cast<uchar>(codec);
+	if(version == 2) {
+		// v2 describes its own length and content, so header size and flags are updated as well
+		qToBigEndian<quint64>(payloadSize, fields + 1);
+		uchar* start = reinterpret_cast<uchar*>(header);
+		int newSize = headerSize + STREAM_HEADER_V2_COMPRESSION_SIZE;
+		qToBigEndian<quint16>(static_cast<quint16>(newSize), start + 6);
+		qToBigEndian<quint16>(qFromBigEndian<quint16>(start + 8) | STREAM_HEADER_V2_FLAG_COMPRESSION, start + 8);
+		return newSize;
+	}
+	qToBigEndian<quint32>(static_cast<quint32>(payloadSize), fields + 1);
+	return headerSize + STREAM_HEADER_COMPRESSION_SIZE;
+}
+
+void StreamHeader::setQualityLevel(char* header, int version, quint8 level) {
+	if(version != 2) {
+		return;
+	}
+	uchar* start = reinterpret_cast<uchar*>(header);
+	qToBigEndian<quint16>(qFromBigEndian<quint16>(start + 8) | STREAM_HEADER_V2_FLAG_ADAPTIVE, start + 8);
+	start[11] = level;
+}
+
+void StreamHeader::serializeChunkHeader(char* chunkHeader, quint32 sequence, quint32 index, quint32 count, quint64 frameSize, quint64 offset) {
+	uchar* fields = reinterpret_cast<uchar*>(chunkHeader);
+	qToBigEndian<quint32>(STREAM_CHUNK_MAGIC, fields);
+	qToBigEndian<quint32>(sequence, fields + 4);
+	qToBigEndian<quint32>(index, fields + 8);
+	qToBigEndian<quint32>(count, fields + 12);
+	qToBigEndian<quint64>(frameSize, fields + 16);
+	qToBigEndian<quint64>(offset, fields + 24);
+}
+
+bool StreamHeader::truncatesFields(const StreamFrame* frame, int version) {
+	return version == 1 && (frame->sizeInBytes > 0xFFFFFFFFull || frame->samplesPerLine > 0xFFFF || frame->linesPerFrame > 0xFFFF);
+}
@@ -0,0 +1,88 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef STREAMHEADER_H
+#define STREAMHEADER_H
+
+#include "framepool.h"
+
+#define STREAM_START_IDENTIFIER 299792458 // identifier (magic number) for synchronization on client side
+#define STREAM_HEADER_BASE_SIZE 13        // identifier, size, width, height, bit depth
+#define STREAM_HEADER_TIMESTAMP_SIZE 8
+#define STREAM_HEADER_COMPRESSION_SIZE 5  // codec, compressed payload size
+
+#define STREAM_START_IDENTIFIER_V2 0x4F435032 // "OCP2", lets clients tell the two header versions apart
+#define STREAM_HEADER_V2_BASE_SIZE 48
+#define STREAM_HEADER_V2_COMPRESSION_SIZE 9   // codec, 64-bit compressed payload size
+#define STREAM_HEADER_V2_FLAG_RAW 0x0001
+#define STREAM_HEADER_V2_FLAG_TIMESTAMP 0x0002
+#define STREAM_HEADER_V2_FLAG_COMPRESSION 0x0004
+#define STREAM_HEADER_V2_FLAG_ADAPTIVE 0x0008
+
+#define STREAM_CHUNK_MAGIC 0x4F435743 // "OCWC", WebSocket chunk of a frame (set_chunking)
+#define STREAM_CHUNK_HEADER_SIZE 32
+#define STREAM_WEBSOCKET_MAX_MESSAGE_SIZE (Q_INT64_C(2147483647) - 64) // largest QByteArray that Qt 5 can allocate, larger frames need set_chunking
+
+// Wire format of the per-frame header that precedes the payload on TCP/IPC
+// and WebSocket connections. All fields are big-endian.
+//
+// Version 1, 13 bytes:
+// [u32 identifier][u32 payload size][u16 width][u16 height][u8 bit depth]
+//
+// Version 2, 48 bytes, opt-in:
+// [u32 identifier v2][u16 version][u16 header size][u16 flags][u8 bit depth][u8 quality level]
+// [u64 sequence number][u64 payload size][u32 samples per line][u32 lines per frame]
+// [u32 frames per buffer][u32 buffers per volume][u32 buffer index]
+//
+// Both versions are followed by [u64 timestamp ms] if enabled and by the compression
+// fields of the client ([u8 codec][u32 size] in v1, [u8 codec][u64 size] in v2).
+// The quality level is 0 unless the client uses set_adaptive (flag 0x0008).
+//
+// WebSocket clients with set_chunking receive every frame (header and payload) as
+// a series of binary messages, each starting with a chunk header:
+// [u32 magic "OCWC"][u32 frame sequence][u32 chunk index][u32 chunk count]
+// [u64 frame size][u64 chunk offset][data]
+namespace StreamHeader {
+	// version 0 writes no header
+	void serialize(StreamFrame* frame, int version, bool includeTimestamp);
+	bool hasTimestamp(const StreamFrame* frame);
+	void buildWebSocketMessage(StreamFrame* frame);
+	// appends the compression fields to a header of headerSize bytes, returns the new header size
+	int appendCompression(char* header, int headerSize, int version, PayloadCompression::Codec codec, quint64 payloadSize);
+	// marks a client's copy of a v2 header with the current adaptive quality level, v1 headers have no room for it
+	void setQualityLevel(char* header, int version, quint8 level);
+	void serializeChunkHeader(char* chunkHeader, quint32 sequence, quint32 index, quint32 count, quint64 frameSize, quint64 offset);
+	// true if a field of the frame does not fit into the header, only possible with version 1
+	bool truncatesFields(const StreamFrame* frame, int version);
+}
+
+#endif // STREAMHEADER_H
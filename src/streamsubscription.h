@@ -0,0 +1,120 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef STREAMSUBSCRIPTION_H
+#define STREAMSUBSCRIPTION_H
+
+#include <QtGlobal>
+#include <QMetaType>
+#include "payloadcompression.h"
+
+#define WEBSOCKET_CHUNK_MIN_SIZE 4096
+#define WEBSOCKET_CHUNK_MAX_SIZE (256 * 1024 * 1024)
+#define MIN_FRAMES_PER_SECOND 0.001 // lowest fps limit, the frame interval in ns has to fit into a qint64
+
+// Crop window with strides in samples (depth), lines (A-scans) and frames of
+// one buffer. Ranges are half-open [begin, end), end = 0 means up to the end.
+struct RegionOfInterest {
+	quint32 sampleBegin = 0;
+	quint32 sampleEnd = 0;
+	quint32 sampleStride = 1;
+	quint32 lineBegin = 0;
+	quint32 lineEnd = 0;
+	quint32 lineStride = 1;
+	quint32 frameBegin = 0;
+	quint32 frameEnd = 0;
+	quint32 frameStride = 1;
+
+	bool isFullBuffer() const {
+		return sampleBegin == 0 && sampleEnd == 0 && sampleStride == 1
+			&& lineBegin == 0 && lineEnd == 0 && lineStride == 1
+			&& frameBegin == 0 && frameEnd == 0 && frameStride == 1;
+	}
+};
+
+// Display-ready preview images for WebSocket clients (set_preview). One B-scan
+// of each accepted buffer is windowed, downsampled and encoded on a worker
+// pool; the client then receives these images instead of the buffers.
+struct PreviewSettings {
+	bool enabled = false;
+	bool png = false;                  // JPEG otherwise
+	int quality = 75;                  // JPEG quality 1..100
+	quint32 maxWidth = 512;            // samples per line are reduced to at most this many pixels
+	quint32 maxHeight = 512;           // lines per frame are reduced to at most this many pixels
+	quint32 frameIndex = 0;            // B-scan of the buffer that is shown
+	float windowMin = 0.0f;            // mapped to black, min = max = 0 uses the range of each image
+	float windowMax = 0.0f;            // mapped to white
+	double maxFramesPerSecond = 15.0;  // 0 = only the limit of set_decimation
+};
+
+// Limits of the automatic quality control of one client (set_adaptive). The
+// Broadcaster steps the level up and down within these limits, see QualityController.
+struct AdaptiveQualitySettings {
+	bool enabled = false;
+	quint8 minBitDepth = 0;            // lowest bit depth the quality may be reduced to (16 or 8), 0 = bit depth is not reduced
+	float windowMin = 0.0f;            // window of the bit depth reduction, unless one was set with set_bit_depth
+	float windowMax = 0.0f;
+	quint32 maxStride = 1;             // largest additional sample and line stride, powers of two are used
+	quint32 maxDecimation = 1;         // largest additional every-N-th-buffer factor, powers of two are used
+	quint8 level = 0;                  // current level, 0 = full quality. Set by the Broadcaster, signalled in the v2 header
+};
+
+// What a single client wants to receive. Set with the client commands that
+// are handled by the Broadcaster (see README), applied by the StreamClient.
+struct StreamSubscription {
+	quint32 everyNthBuffer = 1;        // 1 = every buffer
+	double maxFramesPerSecond = 0.0;   // 0 = no rate limit
+	RegionOfInterest region;
+	quint8 outputBitDepth = 0;         // 8 or 16 to reduce the bit depth, 0 = unchanged
+	float windowMin = 0.0f;            // input values mapped to 0
+	float windowMax = 0.0f;            // input values mapped to the largest output value
+	PayloadCompression::Codec compression = PayloadCompression::None;
+	int compressionLevel = 1;
+	int statsIntervalSeconds = 0;      // periodic get_stats push, 0 = off. Handled by the Broadcaster
+	bool volumeMode = false;           // whole volumes instead of single buffers. Assembled by the Broadcaster
+	PreviewSettings preview;
+	AdaptiveQualitySettings adaptive;
+	bool batching = true;              // batched writes as configured in the extension settings, latency-sensitive clients opt out with set_batching:enable=0
+	quint32 webSocketChunkSize = 0;    // frames are split into WebSocket messages of about this many bytes, 0 = one message per frame
+
+	bool transformsFrames() const { return !region.isFullBuffer() || outputBitDepth != 0; }
+	bool usesSharedWebSocketMessage() const { return !transformsFrames() && compression == PayloadCompression::None && !preview.enabled && webSocketChunkSize == 0 && !adaptive.enabled; }
+	double effectiveMaxFramesPerSecond() const {
+		if(!preview.enabled || preview.maxFramesPerSecond <= 0.0) {
+			return maxFramesPerSecond;
+		}
+		return maxFramesPerSecond > 0.0 ? qMin(maxFramesPerSecond, preview.maxFramesPerSecond) : preview.maxFramesPerSecond;
+	}
+};
+Q_DECLARE_METATYPE(StreamSubscription)
+
+#endif // STREAMSUBSCRIPTION_H
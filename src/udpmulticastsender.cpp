@@ -0,0 +1,209 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "udpmulticastsender.h"
+#include <QNetworkInterface>
+#include <QtEndian>
+#include <cstring>
+#ifdef Q_OS_UNIX
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <errno.h>
+#endif
+
+#define UDP_SEND_BUFFER_SIZE (4 * 1024 * 1024)
+#define UDP_SEND_TIMEOUT_MS 100
+
+UdpMulticastSender::UdpMulticastSender(QObject* parent) : QObject(parent), socket(nullptr), datagramSize(0), sequence(0), framesInFlight(0), sentFrames(0), sentDatagrams(0), dropped(0), incomplete(0), errorReported(false), frameSizeErrorReported(false) {
+}
+
+UdpMulticastSender::~UdpMulticastSender() {
+	this->close();
+}
+
+bool UdpMulticastSender::reserveFrame() {
+	int inFlight = this->framesInFlight.load();
+	do {
+		if(inFlight >= UDP_MAX_FRAMES_IN_FLIGHT) {
+			this->dropped.fetchAndAddRelaxed(1);
+			return false;
+		}
+	} while(!this->framesInFlight.testAndSetOrdered(inFlight, inFlight + 1, inFlight));
+	return true;
+}
+
+void UdpMulticastSender::open(const QString& group, quint16 port, int ttl, int datagramSize, const QString& interfaceIp, int sendBufferSize) {
+	this->close();
+
+	QHostAddress groupAddress(group);
+	if(!groupAddress.isMulticast()) {
+		emit error(tr("UDP multicast: %1 is not a multicast address.").arg(group));
+		return;
+	}
+
+	this->socket = new QUdpSocket(this);
+	if(!this->socket->bind(QHostAddress(QHostAddress::AnyIPv4), 0)) {
+		emit error(tr("UDP multicast: %1").arg(this->socket->errorString()));
+		this->close();
+		return;
+	}
+	this->socket->setSocketOption(QAbstractSocket::MulticastTtlOption, ttl);
+	this->socket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1); // receivers on the same host get the frames too
+	this->socket->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, sendBufferSize > 0 ? sendBufferSize : UDP_SEND_BUFFER_SIZE);
+
+	//without an explicit interface the route of the group decides, a host with several network cards sends on the one that has the configured ip
+	QHostAddress interfaceAddress(interfaceIp);
+	if(!interfaceAddress.isNull() && interfaceAddress != QHostAddress(QHostAddress::AnyIPv4)) {
+		for(const QNetworkInterface& networkInterface : QNetworkInterface::allInterfaces()) {
+			for(const QNetworkAddressEntry& entry : networkInterface.addressEntries()) {
+				if(entry.ip() == interfaceAddress) {
+					this->socket->setMulticastInterface(networkInterface);
+				}
+			}
+		}
+	}
+
+	//a connected udp socket can be written to like a stream socket, the group address does not have to be passed with every datagram
+	this->socket->connectToHost(groupAddress, port, QIODevice::WriteOnly);
+	if(!this->socket->waitForConnected(1000)) {
+		emit error(tr("UDP multicast: %1").arg(this->socket->errorString()));
+		this->close();
+		return;
+	}
+
+	this->datagramSize = qBound(UDP_FRAGMENT_HEADER_SIZE + 64, datagramSize, 65507);
+	this->datagram.resize(this->datagramSize);
+	this->errorReported = false;
+	this->frameSizeErrorReported = false;
+	emit info(tr("Sending frames to UDP multicast group %1:%2 in datagrams of up to %3 bytes.").arg(group).arg(port).arg(this->datagramSize));
+}
+
+void UdpMulticastSender::close() {
+	if(this->socket) {
+		this->socket->close();
+		this->socket->deleteLater();
+		this->socket = nullptr;
+	}
+}
+
+void UdpMulticastSender::sendFrame(FrameRef frame) {
+	if(this->socket && !frame.isNull()) {
+		//the frame is the stream header followed by the payload. Both are copied piecewise into the datagram buffer, so the frame itself is not touched
+		const quint32 headerSize = frame->headerSize;
+		const quint64 frameSize = static_cast<quint64>(headerSize) + frame->sizeInBytes;
+		if(frameSize > UDP_MAX_FRAME_SIZE) {
+			//truncated size and offset fields would make receivers assemble garbage, so such frames are not sent at all
+			this->dropped.fetchAndAddRelaxed(1);
+			if(!this->frameSizeErrorReported) {
+				emit error(tr("UDP multicast: buffers of %1 bytes exceed the 4 GiB limit of the fragment header and are not sent.").arg(frameSize));
+				this->frameSizeErrorReported = true;
+			}
+			this->framesInFlight.fetchAndAddOrdered(-1);
+			return;
+		}
+		const int fragmentPayload = this->datagramSize - UDP_FRAGMENT_HEADER_SIZE;
+		const quint32 fragmentCount = static_cast<quint32>(qMax<quint64>(1, (frameSize + fragmentPayload - 1) / fragmentPayload));
+		const quint32 frameSequence = ++this->sequence;
+
+		uchar* fragmentHeader = reinterpret_cast<uchar*>(this->datagram.data());
+		char* fragmentData = this->datagram.data() + UDP_FRAGMENT_HEADER_SIZE;
+		qToBigEndian<quint32>(UDP_FRAGMENT_MAGIC, fragmentHeader);
+		qToBigEndian<quint32>(frameSequence, fragmentHeader + 4);
+		qToBigEndian<quint32>(fragmentCount, fragmentHeader + 12);
+		qToBigEndian<quint32>(static_cast<quint32>(frameSize), fragmentHeader + 16);
+
+		bool complete = true;
+		for(quint32 index = 0; index < fragmentCount; index++) {
+			quint64 offset = static_cast<quint64>(index) * fragmentPayload;
+			int length = static_cast<int>(qMin<quint64>(fragmentPayload, frameSize - offset));
+			qToBigEndian<quint32>(index, fragmentHeader + 8);
+			qToBigEndian<quint32>(static_cast<quint32>(offset), fragmentHeader + 20);
+
+			int copied = 0;
+			if(offset < headerSize) {
+				copied = qMin(length, static_cast<int>(headerSize - offset));
+				memcpy(fragmentData, frame->header + offset, copied);
+			}
+			if(copied < length) {
+				memcpy(fragmentData + copied, frame->data + (offset + copied - headerSize), length - copied);
+			}
+
+			if(!this->sendDatagram(this->datagram.constData(), UDP_FRAGMENT_HEADER_SIZE + length)) {
+				complete = false; //receivers detect the missing fragments by sequence number and drop the frame
+				break;
+			}
+			this->sentDatagrams.fetchAndAddRelaxed(1);
+		}
+		if(complete) {
+			this->sentFrames.fetchAndAddRelaxed(1);
+		} else {
+			this->incomplete.fetchAndAddRelaxed(1);
+		}
+	}
+	this->framesInFlight.fetchAndAddOrdered(-1);
+}
+
+bool UdpMulticastSender::sendDatagram(const char* data, int size) {
+#ifdef Q_OS_UNIX
+	//udp has no flow control. When the send buffer is full the datagram is retried as soon as the kernel has room again, which paces a large frame to the link speed
+	int descriptor = static_cast<int>(this->socket->socketDescriptor());
+	while(true) {
+		ssize_t result = ::send(descriptor, data, static_cast<size_t>(size), 0);
+		if(result == size) {
+			return true;
+		}
+		if(result < 0 && errno == EINTR) {
+			continue;
+		}
+		if(result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS)) {
+			struct pollfd pending = {descriptor, POLLOUT, 0};
+			if(::poll(&pending, 1, UDP_SEND_TIMEOUT_MS) > 0) {
+				continue;
+			}
+		}
+		break;
+	}
+#else
+	if(this->socket->write(data, size) == size) {
+		return true;
+	}
+	if(this->socket->waitForBytesWritten(UDP_SEND_TIMEOUT_MS) && this->socket->write(data, size) == size) {
+		return true;
+	}
+#endif
+	if(!this->errorReported) {
+		emit error(tr("UDP multicast: a datagram could not be sent within %1 ms, frames are sent incomplete.").arg(UDP_SEND_TIMEOUT_MS));
+		this->errorReported = true;
+	}
+	return false;
+}
@@ -0,0 +1,96 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef UDPMULTICASTSENDER_H
+#define UDPMULTICASTSENDER_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QAtomicInteger>
+#include "framepool.h"
+
+#define UDP_FRAGMENT_MAGIC 0x4F43544D // "OCTM"
+#define UDP_FRAGMENT_HEADER_SIZE 24
+#define UDP_MAX_FRAMES_IN_FLIGHT 2
+#define UDP_MAX_FRAME_SIZE Q_UINT64_C(0xFFFFFFFF) // frame size and fragment offset are 32 bit fields
+
+// Fragment header in front of every datagram, all fields big-endian like the stream header.
+// A frame is the stream header (if enabled) followed by the payload, the same bytes a TCP client receives.
+// See examples/octproz_udp_multicast_receiver.py
+//
+// [u32 magic][u32 frame sequence][u32 fragment index][u32 fragment count][u32 frame size][u32 fragment offset][data]
+//
+// Sends every frame once to a multicast group, so the egress cost does not depend on the number of receivers.
+// Lives in a thread of its own, frames that arrive while UDP_MAX_FRAMES_IN_FLIGHT frames are still being sent are dropped.
+// Frames larger than UDP_MAX_FRAME_SIZE can not be described by the fragment header and are dropped as well.
+class UdpMulticastSender : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit UdpMulticastSender(QObject* parent = nullptr);
+	~UdpMulticastSender();
+
+	bool reserveFrame(); // called by the broadcaster before sendFrame is queued, false if the frame has to be dropped
+	quint64 framesSent() const { return this->sentFrames.load(); }
+	quint64 datagramsSent() const { return this->sentDatagrams.load(); }
+	quint64 droppedFrames() const { return this->dropped.load(); }
+	quint64 incompleteFrames() const { return this->incomplete.load(); }
+
+public slots:
+	void open(const QString& group, quint16 port, int ttl, int datagramSize, const QString& interfaceIp, int sendBufferSize); // sendBufferSize in bytes, 0 = 4 MB
+	void sendFrame(FrameRef frame);
+	void close();
+
+signals:
+	void error(const QString message);
+	void info(const QString message);
+
+private:
+	bool sendDatagram(const char* data, int size);
+
+	QUdpSocket* socket;
+	QByteArray datagram;
+	int datagramSize;
+	quint32 sequence;
+	QAtomicInteger<int> framesInFlight;
+	QAtomicInteger<quint64> sentFrames;
+	QAtomicInteger<quint64> sentDatagrams;
+	QAtomicInteger<quint64> dropped;
+	QAtomicInteger<quint64> incomplete;
+	bool errorReported;
+	bool frameSizeErrorReported;
+};
+
+#endif // UDPMULTICASTSENDER_H
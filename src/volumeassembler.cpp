@@ -0,0 +1,108 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#include "volumeassembler.h"
+#include <cstring>
+
+VolumeAssembler::VolumeAssembler() : nextBufferNr(0), bufferSizeInBytes(0), assembled(0), dropped(0) {
+}
+
+FrameRef VolumeAssembler::addBuffer(const FrameRef& buffer) {
+	if(buffer->buffersPerVolume <= 1) {
+		return buffer; // every buffer is a complete volume
+	}
+	if(this->pool.isNull()) {
+		this->pool = QSharedPointer<FramePool>(new FramePool(VOLUME_POOL_SLOTS));
+	}
+
+	if(buffer->currentBufferNr == 0) {
+		if(!this->volume.isNull()) {
+			this->dropped++; // the previous volume did not get its last buffer
+		}
+		this->volume = this->pool->acquire(buffer->sizeInBytes * buffer->buffersPerVolume);
+		if(this->volume.isNull()) {
+			this->dropped++; // all volume slots are still queued for slow clients
+			return FrameRef();
+		}
+		this->nextBufferNr = 0;
+		this->bufferSizeInBytes = buffer->sizeInBytes;
+		this->volume->bitDepth = buffer->bitDepth;
+		this->volume->samplesPerLine = buffer->samplesPerLine;
+		this->volume->linesPerFrame = buffer->linesPerFrame;
+		this->volume->framesPerBuffer = buffer->framesPerBuffer;
+		this->volume->buffersPerVolume = buffer->buffersPerVolume;
+		this->volume->sequenceNumber = buffer->sequenceNumber;
+		this->volume->isRaw = buffer->isRaw;
+		this->volume->receivedNs = buffer->receivedNs;
+	}
+	if(this->volume.isNull()) {
+		return FrameRef(); // waiting for the first buffer of the next volume
+	}
+
+	// a missing buffer or a geometry change in the middle of a volume makes the whole volume useless
+	if(buffer->currentBufferNr != this->nextBufferNr || !this->matchesVolume(buffer.data())) {
+		this->volume.reset();
+		this->dropped++;
+		return FrameRef();
+	}
+
+	memcpy(this->volume->data + static_cast<quint64>(this->nextBufferNr) * this->bufferSizeInBytes, buffer->data, static_cast<size_t>(this->bufferSizeInBytes));
+	this->nextBufferNr++;
+	if(this->nextBufferNr < this->volume->buffersPerVolume) {
+		return FrameRef();
+	}
+
+	// the volume goes out as a single buffer that contains all frames of the volume
+	FrameRef complete = this->volume;
+	this->volume.reset();
+	complete->framesPerBuffer = complete->framesPerBuffer * complete->buffersPerVolume;
+	complete->buffersPerVolume = 1;
+	complete->currentBufferNr = 0;
+	this->assembled++;
+	return complete;
+}
+
+void VolumeAssembler::reset() {
+	// frames still queued for clients keep their memory until they are released, the pool handles that
+	this->volume.reset();
+	this->pool.reset();
+	this->nextBufferNr = 0;
+}
+
+bool VolumeAssembler::matchesVolume(const StreamFrame* buffer) const {
+	return buffer->sizeInBytes == this->bufferSizeInBytes
+		&& buffer->buffersPerVolume == this->volume->buffersPerVolume
+		&& buffer->bitDepth == this->volume->bitDepth
+		&& buffer->samplesPerLine == this->volume->samplesPerLine
+		&& buffer->linesPerFrame == this->volume->linesPerFrame
+		&& buffer->framesPerBuffer == this->volume->framesPerBuffer;
+}
@@ -0,0 +1,68 @@
+/**
+**  This file is part of SocketStreamExtension for OCTproZ.
+**  Copyright (C) 2020,2024 Miroslav Zabic
+**
+**  SocketStreamExtension is an OCTproZ extension designed for streaming
+**  processed OCT data, supporting inter-process communication via local
+**  socket connections (using Unix Domain Sockets on Unix/Linux and Named
+**  Pipes on Windows) and network communication across computers via TCP/IP.
+**  This enables OCT image data streaming to different applications on the
+**  same computer or to different computers on the same network.
+**
+**  SocketStreamExtension is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program. If not, see http://www.gnu.org/licenses/.
+**
+****
+** Author:	Miroslav Zabic
+** Contact:	zabic
+**			at
+**			spectralcode.de
+****
+**/
+
+#ifndef VOLUMEASSEMBLER_H
+#define VOLUMEASSEMBLER_H
+
+#include <QSharedPointer>
+#include "framepool.h"
+
+#define VOLUME_POOL_SLOTS 3 // one volume being assembled, one being sent and one waiting in a send queue
+
+// Gathers the buffers of a volume (currentBufferNr 0 .. buffersPerVolume-1) into
+// one contiguous frame from its own pool of volume-sized slots. A volume is only
+// handed out when all of its buffers arrived in order, otherwise it is dropped whole.
+// The slots are allocated with the first volume and freed again by reset().
+class VolumeAssembler {
+public:
+	VolumeAssembler();
+
+	// returns the complete volume once its last buffer was added, otherwise a null FrameRef
+	FrameRef addBuffer(const FrameRef& buffer);
+	void reset();
+
+	bool isActive() const { return !this->pool.isNull(); }
+	quint64 assembledCount() const { return this->assembled; }
+	quint64 droppedCount() const { return this->dropped; }
+
+private:
+	bool matchesVolume(const StreamFrame* buffer) const;
+
+	QSharedPointer<FramePool> pool;
+	FrameRef volume;
+	quint32 nextBufferNr;
+	quint64 bufferSizeInBytes;
+	quint64 assembled;
+	quint64 dropped;
+};
+
+#endif // VOLUMEASSEMBLER_H
@@ -0,0 +1,147 @@
+"""
+Test script for set_adaptive combined with set_preview of OCTproZ Socket Stream Extension.
+
+The preview skips buffers on purpose while an image is encoded or sent. These skips must be reported as
+previews_skipped and must not count as dropped frames, otherwise set_adaptive would take them for congestion
+and step the connection down to its lowest quality level.
+
+Usage:
+    python test_adaptive_preview.py [--host HOST] [--port PORT] [--seconds S]
+
+Defaults: host=127.0.0.1, port=1234 (the WebSocket port of the extension), seconds=8
+Requires: OCTproZ running with Socket Stream Extension listening for WebSocket clients and acquisition running,
+          faster than the images can be encoded and sent, so that the preview skips buffers.
+Uses a minimal WebSocket client from the standard library, no additional packages.
+"""
+
+import argparse
+import base64
+import json
+import os
+import socket
+import struct
+import time
+
+
+def websocket_connect(host, port):
+    sock = socket.create_connection((host, port))
+    key = base64.b64encode(os.urandom(16)).decode('ascii')
+    request = (f"GET / HTTP/1.1\r\nHost: {host}:{port}\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+               f"Sec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n\r\n")
+    sock.sendall(request.encode('ascii'))
+    response = b""
+    while b"\r\n\r\n" not in response:
+        chunk = sock.recv(4096)
+        if not chunk:
+            raise ConnectionError("Connection closed during the WebSocket handshake")
+        response += chunk
+    assert b" 101 " in response.split(b"\r\n", 1)[0], f"Handshake failed: {response[:100]}"
+    return sock
+
+
+def send_text(sock, text):
+    """Client frames have to be masked."""
+    payload = text.encode('utf-8')
+    mask = os.urandom(4)
+    if len(payload) < 126:
+        header = struct.pack("!BB", 0x81, 0x80 | len(payload))
+    else:
+        header = struct.pack("!BBH", 0x81, 0x80 | 126, len(payload))
+    sock.sendall(header + mask + bytes(b ^ mask[i % 4] for i, b in enumerate(payload)))
+
+
+def receive_exactly(sock, size):
+    data = b""
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        if not chunk:
+            raise ConnectionError("Connection closed")
+        data += chunk
+    return data
+
+
+def receive_message(sock):
+    """Returns (opcode, payload) of the next message, fragmented messages are not used by the extension."""
+    first, second = receive_exactly(sock, 2)
+    size = second & 0x7F
+    if size == 126:
+        size = struct.unpack("!H", receive_exactly(sock, 2))[0]
+    elif size == 127:
+        size = struct.unpack("!Q", receive_exactly(sock, 8))[0]
+    return first & 0x0F, receive_exactly(sock, size)
+
+
+def receive_text_until(sock, predicate, timeout=5.0):
+    """Reads messages until a text message satisfies predicate, binary preview images are counted and skipped."""
+    images = 0
+    deadline = time.monotonic() + timeout
+    sock.settimeout(timeout)
+    while time.monotonic() < deadline:
+        opcode, payload = receive_message(sock)
+        if opcode == 0x2:
+            images += 1
+        elif opcode == 0x1:
+            text = payload.decode('utf-8').strip()
+            if predicate(text):
+                return text, images
+    raise TimeoutError("Expected reply did not arrive")
+
+
+def run_test(host, port, seconds):
+    sock = websocket_connect(host, port)
+    try:
+        send_text(sock, "set_preview:enable=1:fps=1000:width=256:height=256")
+        reply, _ = receive_text_until(sock, lambda text: text.startswith("Preview enabled") or "error" in text.lower())
+        print(f"  {reply}")
+        assert reply.startswith("Preview enabled"), f"set_preview rejected: {reply}"
+
+        send_text(sock, "set_adaptive:enable=1:max_stride=4:max_decimation=4")
+        reply, _ = receive_text_until(sock, lambda text: text.startswith("Adaptive quality") or "error" in text.lower())
+        print(f"  {reply}")
+        assert reply.startswith("Adaptive quality enabled"), f"set_adaptive rejected: {reply}"
+
+        # the controller runs once per second, a few seconds are enough to reach the lowest level if skips counted as drops
+        images = 0
+        deadline = time.monotonic() + seconds
+        sock.settimeout(5.0)  # a timeout within a message would break the framing, so it only guards against a stopped acquisition
+        while time.monotonic() < deadline:
+            opcode, _ = receive_message(sock)
+            if opcode == 0x2:
+                images += 1
+
+        send_text(sock, "get_stats")
+        reply, more_images = receive_text_until(sock, lambda text: text.startswith('{'))
+        images += more_images
+        stats = json.loads(reply)
+        own = [client for client in stats["clients"] if client["transport"] == "websocket" and client.get("receives_data")]
+        assert own, f"No WebSocket data connection in get_stats: {reply}"
+        entry = own[-1]
+        print(f"  Images received: {images}")
+        print(f"  previews_skipped={entry.get('previews_skipped')} frames_dropped={entry['frames_dropped']} "
+              f"quality_level={entry.get('quality_level')} of {entry.get('quality_levels')}")
+
+        assert images > 0, "No preview images received, is the acquisition running?"
+        assert 'previews_skipped' in entry, "previews_skipped missing in get_stats"
+        if entry['previews_skipped'] == 0:
+            print("  WARNING: no buffers were skipped, the test is only meaningful with a faster acquisition")
+        assert entry['frames_dropped'] == 0, "Preview skips were counted as dropped frames"
+        assert entry.get('quality_level') == 0, "set_adaptive lowered the quality although the link keeps up with the preview"
+        print("  PASSED")
+    finally:
+        sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Test set_adaptive together with set_preview for OCTproZ")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=1234)
+    parser.add_argument("--seconds", type=float, default=8.0)
+    args = parser.parse_args()
+
+    print("\n--- set_adaptive with set_preview ---")
+    run_test(args.host, args.port, args.seconds)
+    print("\nAll tests passed.")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,155 @@
+"""
+Test script for the command framing of OCTproZ Socket Stream Extension.
+
+Tests: several commands in one write, a command split over several writes (also with long pauses),
+       \\r\\n line endings, empty lines, commands without newline (older clients) and binary commands
+       mixed with text commands.
+
+Usage:
+    python test_command_pipelining.py [--host HOST] [--port PORT]
+
+Defaults: host=127.0.0.1, port=1234
+Requires: OCTproZ running with Socket Stream Extension connected and broadcasting stopped.
+"""
+
+import socket
+import struct
+import time
+import argparse
+
+BINARY_OPCODE_PING = 0x0001
+
+
+def binary_command(opcode, payload=b""):
+    """Binary command frame: marker 0x02, u16 opcode, u32 payload size, payload (little-endian)."""
+    return struct.pack('<BHI', 0x02, opcode, len(payload)) + payload
+
+
+def receive_lines(sock, count, timeout=2.0):
+    """Read until count reply lines arrived or the timeout expired."""
+    data = b""
+    deadline = time.monotonic() + timeout
+    while data.count(b"\n") < count and time.monotonic() < deadline:
+        sock.settimeout(max(0.01, deadline - time.monotonic()))
+        try:
+            chunk = sock.recv(4096)
+        except socket.timeout:
+            break
+        if not chunk:
+            break
+        data += chunk
+    sock.settimeout(None)
+    return [line.strip() for line in data.decode('utf-8').splitlines() if line.strip()]
+
+
+def test_pipelined(sock):
+    print("\n--- Several commands in one write ---")
+    sock.sendall(b"ping\nping\nping\n")
+    replies = receive_lines(sock, 3)
+    print(f"  Replies: {replies}")
+    assert replies == ["pong"] * 3, f"Expected 3 x 'pong', got {replies}"
+    print("  PASSED")
+
+
+def test_split(sock):
+    print("\n--- One command split over several writes ---")
+    for part in (b"pi", b"n", b"g\n"):
+        sock.sendall(part)
+        time.sleep(0.02)  # shorter than the idle timeout, the parts must not be taken as commands
+    replies = receive_lines(sock, 1)
+    print(f"  Replies: {replies}")
+    assert replies == ["pong"], f"Expected 'pong', got {replies}"
+    print("  PASSED")
+
+
+def test_split_slow(sock):
+    print("\n--- Newline terminated command split with pauses longer than the idle timeout ---")
+    for part in (b"pi", b"n", b"g\n"):
+        sock.sendall(part)
+        time.sleep(0.3)  # after its first newline a client is no longer treated as legacy, the parts must wait for the newline
+    replies = receive_lines(sock, 1)
+    print(f"  Replies: {replies}")
+    assert replies == ["pong"], f"Expected 'pong', got {replies}"
+    print("  PASSED")
+
+
+def test_crlf_and_empty_lines(sock):
+    print("\n--- \\r\\n line endings and empty lines ---")
+    sock.sendall(b"\r\nping\r\n\n  \nping\r\n")
+    replies = receive_lines(sock, 2)
+    print(f"  Replies: {replies}")
+    assert replies == ["pong"] * 2, f"Expected 2 x 'pong', got {replies}"
+    print("  PASSED")
+
+
+def test_without_newline(sock):
+    print("\n--- Command without newline ---")
+    sock.sendall(b"ping")
+    replies = receive_lines(sock, 1)
+    print(f"  Replies: {replies}")
+    assert replies == ["pong"], f"Expected 'pong', got {replies}"
+    print("  PASSED")
+
+
+def test_without_newline_separate_writes(sock):
+    print("\n--- Two commands without newline, each write followed by a read ---")
+    # older clients wait for the reply before they send the next command, so every write is taken as one command
+    replies = []
+    for command in (b"ping", b"ping"):
+        sock.sendall(command)
+        replies += receive_lines(sock, 1)
+    print(f"  Replies: {replies}")
+    assert replies == ["pong"] * 2, f"Expected 2 x 'pong', got {replies}"
+    print("  PASSED")
+
+
+def test_binary_mixed(sock):
+    print("\n--- Binary commands mixed with text commands ---")
+    sock.sendall(binary_command(BINARY_OPCODE_PING) + b"ping\n" + binary_command(BINARY_OPCODE_PING))
+    replies = receive_lines(sock, 3)
+    print(f"  Replies: {replies}")
+    assert replies == ["pong"] * 3, f"Expected 3 x 'pong', got {replies}"
+    print("  PASSED")
+
+
+def test_binary_split(sock):
+    print("\n--- Binary command split over several writes ---")
+    frame = binary_command(BINARY_OPCODE_PING)
+    for i in range(len(frame)):
+        sock.sendall(frame[i:i + 1])
+        time.sleep(0.15)  # longer than the idle timeout, an incomplete binary command must still wait for its rest
+    replies = receive_lines(sock, 1)
+    print(f"  Replies: {replies}")
+    assert replies == ["pong"], f"Expected 'pong', got {replies}"
+    print("  PASSED")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Test command pipelining for OCTproZ")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=1234)
+    args = parser.parse_args()
+
+    # the idle fallback only applies to connections that never sent a newline, so the legacy tests get a connection of their own
+    legacy = socket.create_connection((args.host, args.port))
+    try:
+        test_without_newline(legacy)
+        test_without_newline_separate_writes(legacy)
+    finally:
+        legacy.close()
+
+    sock = socket.create_connection((args.host, args.port))
+    try:
+        test_pipelined(sock)
+        test_split(sock)
+        test_split_slow(sock)
+        test_crlf_and_empty_lines(sock)
+        test_binary_mixed(sock)
+        test_binary_split(sock)
+    finally:
+        sock.close()
+    print("\nAll tests passed.")
+
+
+if __name__ == '__main__':
+    main()
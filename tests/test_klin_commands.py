@@ -13,6 +13,7 @@ and checks whether OCTproZ reports an error. It prints PASS/FAIL for each test.
 """
 
 import socket
+import struct
 import sys
 import os
 import time
@@ -35,6 +36,17 @@ def send_command(sock, command):
         return ""
 
 
+def send_binary_command(sock, opcode, payload):
+    """Send a binary command (marker 0x02, u16 opcode, u32 payload size, little-endian) and return any response."""
+    sock.sendall(struct.pack("<BHI", 0x02, opcode, len(payload)) + payload)
+    time.sleep(0.3)
+    try:
+        data = sock.recv(4096)
+        return data.decode("utf-8").strip()
+    except socket.timeout:
+        return ""
+
+
 def run_tests(host, port, csv_path):
     results = []
 
@@ -115,7 +127,20 @@ def run_tests(host, port, csv_path):
     else:
         print(f"WARNING: sample_klin_curve2.csv not found at {csv2_path}, skipping curve switching test")
 
-    # --- Test 9: verify connection still alive with ping ---
+    # --- Test 9: binary set_klin_curve ---
+    name = "binary set_klin_curve (valid)"
+    curve = [i + 0.0001 * i * i / 2048 for i in range(2048)]
+    response = send_binary_command(sock, 0x0103, struct.pack(f"<I{len(curve)}f", len(curve), *curve))
+    passed = "error" not in response.lower() and "invalid" not in response.lower()
+    results.append((name, passed, response))
+
+    # --- Test 10: binary set_klin_curve with fewer values than announced ---
+    name = "binary set_klin_curve (truncated, expect error)"
+    response = send_binary_command(sock, 0x0103, struct.pack("<I3f", 4, 0.0, 1.0, 2.0))
+    passed = True  # should error gracefully
+    results.append((name, passed, response))
+
+    # --- Test 11: verify connection still alive with ping ---
     name = "ping (connection still alive)"
     response = send_command(sock, "ping")
     passed = "pong" in response.lower()
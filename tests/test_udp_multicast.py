@@ -0,0 +1,153 @@
+"""
+Test script for the UDP multicast transport of OCTproZ Socket Stream Extension.
+
+Loopback test (default): frames are fragmented exactly like the extension does it and sent to a multicast group
+on this host. One fragment of one frame and one complete frame are left out on purpose. The reference receiver
+from the examples folder has to reassemble all other frames bit-exact and report one incomplete and one missed frame.
+
+Live test (--live): connects to the control channel of a running extension in UDP Multicast mode,
+joins the announced group and checks that complete frames with a valid stream header arrive.
+
+Usage:
+    python test_udp_multicast.py [--group GROUP] [--group-port PORT] [--datagram-size BYTES]
+    python test_udp_multicast.py --live [--host HOST] [--port PORT]
+
+Defaults: group=239.255.0.1, group-port=5556, datagram-size=1472, host=127.0.0.1, port=1234
+Requires: a network interface with multicast loopback (any Linux/Windows host).
+Live test requires: OCTproZ running with Socket Stream Extension in UDP Multicast mode and "Include header" enabled.
+"""
+
+import argparse
+import os
+import random
+import socket
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'examples'))
+from octproz_udp_multicast_receiver import (FrameReassembler, parse_frame, open_multicast_socket,
+                                             group_from_control_channel, FRAGMENT_FORMAT, FRAGMENT_HEADER_SIZE,
+                                             FRAGMENT_MAGIC, STREAM_HEADER_FORMAT, STREAM_START_IDENTIFIER)
+
+
+def fragment(sequence, frame, datagram_size):
+    """Split a frame into datagrams with the fragment header of UdpMulticastSender."""
+    payload_size = datagram_size - FRAGMENT_HEADER_SIZE
+    count = max(1, (len(frame) + payload_size - 1) // payload_size)
+    datagrams = []
+    for index in range(count):
+        offset = index * payload_size
+        header = struct.pack(FRAGMENT_FORMAT, FRAGMENT_MAGIC, sequence, index, count, len(frame), offset)
+        datagrams.append(header + frame[offset:offset + payload_size])
+    return datagrams
+
+
+def make_frame(width, height, seed):
+    payload = random.Random(seed).randbytes(width * height) if hasattr(random.Random, 'randbytes') \
+        else bytes(random.Random(seed).getrandbits(8) for _ in range(width * height))
+    return struct.pack(STREAM_HEADER_FORMAT, STREAM_START_IDENTIFIER, len(payload), width, height, 8) + payload
+
+
+def test_loopback(group, group_port, datagram_size):
+    print(f"\n--- Loopback test on {group}:{group_port}, {datagram_size} byte datagrams ---")
+    receiver = open_multicast_socket(group, group_port)
+    receiver.settimeout(1.0)
+    sender = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_UDP)
+    sender.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_TTL, 1)
+    sender.setsockopt(socket.IPPROTO_IP, socket.IP_MULTICAST_LOOP, 1)
+
+    frame_count = 12
+    lost_fragment_frame = 4   # one datagram of this frame is not sent
+    lost_frame = 8            # no datagram of this frame is sent
+    frames = {sequence: make_frame(256, 64 + sequence, sequence) for sequence in range(1, frame_count + 1)}
+
+    reassembler = FrameReassembler()
+    received = {}
+    try:
+        for sequence, frame in frames.items():
+            datagrams = fragment(sequence, frame, datagram_size)
+            if sequence == lost_frame:
+                continue
+            if sequence == lost_fragment_frame:
+                del datagrams[len(datagrams) // 2]
+            for datagram in datagrams:
+                sender.sendto(datagram, (group, group_port))
+            # drain after every frame, so the loopback test does not depend on the size of the receive buffer
+            while True:
+                try:
+                    result = reassembler.feed(receiver.recv(65535))
+                except socket.timeout:
+                    break
+                if result is not None:
+                    received[result[0]] = result[1]
+                    if result[0] == sequence:
+                        break
+    finally:
+        sender.close()
+        receiver.close()
+
+    expected = set(frames) - {lost_fragment_frame, lost_frame}
+    assert set(received) == expected, f"Received frames {sorted(received)}, expected {sorted(expected)}"
+    for sequence in expected:
+        assert received[sequence] == frames[sequence], f"Frame {sequence} differs after reassembly"
+        width, height, bit_depth, payload = parse_frame(received[sequence])
+        assert (width, height, bit_depth) == (256, 64 + sequence, 8), f"Frame {sequence}: wrong stream header"
+    assert reassembler.incomplete_frames == 1, f"Expected 1 incomplete frame, got {reassembler.incomplete_frames}"
+    assert reassembler.missed_frames == 1, f"Expected 1 missed frame, got {reassembler.missed_frames}"
+    print(f"  {len(received)} frames reassembled bit-exact, incomplete {reassembler.incomplete_frames}, missed {reassembler.missed_frames}")
+    print("  PASSED")
+
+
+def test_live(host, port, frames_to_receive=20, timeout=10.0):
+    print(f"\n--- Live test with the extension at {host}:{port} ---")
+    control_sock, group, group_port = group_from_control_channel(host, port)
+    print(f"  Handshake: udp_multicast:{group}:{group_port}")
+    receiver = open_multicast_socket(group, group_port)
+    receiver.settimeout(1.0)
+    reassembler = FrameReassembler()
+    complete = 0
+    deadline = time.monotonic() + timeout
+    try:
+        control_sock.sendall(b"ping\n")
+        assert control_sock.recv(4096).decode('utf-8').strip() == "pong", "Control channel does not answer"
+        while complete < frames_to_receive and time.monotonic() < deadline:
+            try:
+                result = reassembler.feed(receiver.recv(65535))
+            except socket.timeout:
+                continue
+            if result is None:
+                continue
+            width, height, bit_depth, payload = parse_frame(result[1])
+            assert width is not None, "Frame without stream header, enable 'Include header' in the extension"
+            assert len(payload) > 0, "Empty payload"
+            complete += 1
+    finally:
+        receiver.close()
+        control_sock.close()
+
+    assert complete >= frames_to_receive, f"Only {complete} complete frames within {timeout} s, is acquisition running?"
+    print(f"  {complete} frames received, last {width}x{height} {bit_depth}-bit, "
+          f"incomplete {reassembler.incomplete_frames}, missed {reassembler.missed_frames}")
+    print("  PASSED")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Test the UDP multicast transport of OCTproZ")
+    parser.add_argument("--live", action="store_true", help="Test against a running extension instead of the loopback sender")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=1234)
+    parser.add_argument("--group", default="239.255.0.1")
+    parser.add_argument("--group-port", type=int, default=5556)
+    parser.add_argument("--datagram-size", type=int, default=1472)
+    args = parser.parse_args()
+
+    if args.live:
+        test_live(args.host, args.port)
+    else:
+        test_loopback(args.group, args.group_port, args.datagram_size)
+    print("\nAll tests passed.")
+
+
+if __name__ == '__main__':
+    main()